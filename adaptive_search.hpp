@@ -0,0 +1,274 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  A searcher that measures the corpus before it picks an algorithm.
+//
+//  Which algorithm is fastest depends as much on the corpus as on the pattern:
+//  on random data Horspool skips almost a whole pattern length at a time, on
+//  small alphabets its skips shrink to a few elements (and a SIMD filter on the
+//  first and last elements wins), and on repetitive data every alignment
+//  matches for a while before it fails, so that anything but a linear-time
+//  algorithm goes quadratic.
+//
+//  adaptive_searcher starts with a Horspool scan that counts its alignments
+//  and comparisons. After k_sample elements it looks at the comparisons per
+//  element and per alignment, and carries on with the first of
+//
+//      linear          Knuth-Morris-Pratt, if there are more than
+//                      k_linear_cost comparisons per element (the scan has
+//                      gone quadratic)
+//      boyer_moore     if there are more than k_boyer_moore_cost comparisons
+//                      per element; the good suffix rule keeps the shifts long
+//                      when most alignments match for a while
+//      simd_prefilter  the SIMD first/last element filter, for contiguous
+//                      integers compared with ==. It streams through memory,
+//                      so it beats Horspool's scattered reads even when
+//                      Horspool's shifts are long.
+//      boyer_moore     if there are more than k_good_suffix_cost comparisons
+//                      per alignment
+//      horspool        otherwise
+//
+//  The measurements and the decision are kept in an adaptive_state. Calling
+//  the searcher as usual makes the decision afresh for each corpus; to keep
+//  it across the buffers of a stream (or the calls of a find-all loop), pass
+//  the same state to search () each time.
+//
+
+#ifndef TBA_ADAPTIVE_SEARCH_HPP
+#define TBA_ADAPTIVE_SEARCH_HPP
+
+#include "searching.hpp"
+#include "integer_search.hpp"
+
+namespace tba {
+
+    enum class search_strategy { undecided, horspool, boyer_moore, simd_prefilter, linear };
+
+//  What an adaptive_searcher has measured so far, and what it decided
+    struct adaptive_state {
+        search_strategy strategy = search_strategy::undecided;
+        std::size_t sampled     = 0;    // elements the probe has moved past
+        std::size_t alignments  = 0;    // alignments the probe has tested
+        std::size_t comparisons = 0;    // element comparisons it made doing so
+        };
+
+    template <typename ForwardIterator,
+              typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+              typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+    class adaptive_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::value_type      value_type;
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+        typedef typename BM_traits<ForwardIterator, Hash, BinaryPredicate>::skip_table_t skip_table_t;
+
+    //  The SIMD filter compares elements with ==, so it is only used when that is the predicate
+        static const bool k_simd_pattern = std::is_integral<value_type>::value && !std::is_same<value_type, bool>::value
+                                        && std::is_same<BinaryPredicate, std::equal_to<value_type>>::value;
+    public:
+        static const std::size_t k_sample = 16 * 1024;     // elements to measure before deciding
+        static constexpr double  k_linear_cost = 64;        // comparisons per element
+        static constexpr double  k_boyer_moore_cost = 2;    // comparisons per element
+        static constexpr double  k_good_suffix_cost = 1.5;  // comparisons per alignment
+
+        adaptive_searcher ( ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ())
+                : pattern_ ( first, last ), pred_ ( pred ),
+                  k_pattern_length ( pattern_.size ()),
+                  skip_ ( k_pattern_length, k_pattern_length, hash, pred ),
+                  fail_ ( k_pattern_length ),
+                  bm_ ( pattern_.begin (), pattern_.end (), hash, pred ) {
+            for ( difference_type i = 0; i + 1 < k_pattern_length; ++i )
+                skip_.insert ( pattern_ [ i ], k_pattern_length - 1 - i );
+            this->build_failure_table ();
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        ///
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            adaptive_state state;
+            return this->search ( corpus_first, corpus_last, state );
+            }
+
+        /// \fn search ( corpusIter corpus_first, corpusIter corpus_last, adaptive_state &state )
+        /// \brief Searches the corpus, measuring it and deciding on an algorithm if state has not decided yet
+        template <typename RandomAccessIterator>
+        RandomAccessIterator
+        search ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, adaptive_state &state ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<value_type>::type,
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( k_pattern_length == 0 )       return corpus_first; // empty pattern matches at start
+
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( std::distance ( corpus_first, corpus_last ) < k_pattern_length )
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last, state );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern, deciding on an algorithm once for the whole corpus
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            adaptive_state state;
+            return detail::count_by_search ( corpus_first, corpus_last, pattern_.size (), mode,
+                [this, &state] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l, state ); });
+            }
+
+    private:
+        std::vector<value_type> pattern_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+        skip_table_t skip_;                         // Horspool's bad character shifts
+        std::vector<std::size_t> fail_;             // Knuth-Morris-Pratt's failure function
+    //  Keeps its own shared copy of the pattern, so that copies of this searcher stay valid
+        owning_searcher<value_type, boyer_moore_searcher<const value_type *, Hash, BinaryPredicate>> bm_;
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator do_search ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, adaptive_state &state ) const {
+            RandomAccessIterator curPos = corpus_first;
+            if ( state.strategy == search_strategy::undecided ) {
+                const RandomAccessIterator it = this->probe ( curPos, corpus_last, state );
+                if ( it != corpus_last || state.strategy == search_strategy::undecided )
+                    return it;
+                }
+
+            switch ( state.strategy ) {
+                case search_strategy::linear:
+                    return this->kmp_search ( curPos, corpus_last );
+                case search_strategy::simd_prefilter:
+                    return this->simd_search ( curPos, corpus_last,
+                        std::integral_constant<bool, k_simd_pattern && detail::is_contiguous_integers<RandomAccessIterator>::value> ());
+                case search_strategy::boyer_moore:
+                    return bm_ ( curPos, corpus_last );
+                default:
+                    return this->horspool_search ( curPos, corpus_last );
+                }
+            }
+
+    //  Horspool, counting as it goes, until the state has seen k_sample elements.
+    //  Returns the match, if any; otherwise curPos is left at the first alignment
+    //  that has not been tested, and (if enough has been seen) the state has decided.
+        template <typename RandomAccessIterator>
+        RandomAccessIterator probe ( RandomAccessIterator &curPos, RandomAccessIterator corpus_last, adaptive_state &state ) const {
+            const RandomAccessIterator lastPos = corpus_last - k_pattern_length;
+            const difference_type budget = static_cast<difference_type> ( state.sampled < k_sample ? k_sample - state.sampled : 0 );
+            const RandomAccessIterator stopPos = lastPos - curPos < budget ? lastPos + 1 : curPos + budget;
+            const RandomAccessIterator startPos = curPos;
+
+            while ( curPos < stopPos ) {
+                ++state.alignments;
+                difference_type j = k_pattern_length - 1;
+                ++state.comparisons;
+                while ( pred_ ( pattern_ [ j ], curPos [ j ] )) {
+                    if ( j == 0 ) {
+                        state.sampled += curPos - startPos;
+                        return curPos;
+                        }
+                    --j;
+                    ++state.comparisons;
+                    }
+                curPos += skip_ [ curPos [ k_pattern_length - 1 ]];
+                }
+
+            state.sampled += curPos - startPos;
+            if ( curPos > lastPos )
+                return corpus_last;         // nothing left to search; decide on a later call, if there is one
+            if ( state.sampled >= k_sample )
+                state.strategy = this->decide ( state, detail::is_contiguous_integers<RandomAccessIterator>::value );
+            return corpus_last;
+            }
+
+        search_strategy decide ( const adaptive_state &state, bool contiguous ) const {
+            const double per_element   = static_cast<double> ( state.comparisons ) / std::max<std::size_t> ( state.sampled, 1 );
+            const double per_alignment = static_cast<double> ( state.comparisons ) / std::max<std::size_t> ( state.alignments, 1 );
+            if ( per_element > k_linear_cost )
+                return search_strategy::linear;
+            if ( per_element > k_boyer_moore_cost )
+                return search_strategy::boyer_moore;
+            if ( k_simd_pattern && contiguous )
+                return search_strategy::simd_prefilter;
+            if ( per_alignment > k_good_suffix_cost )
+                return search_strategy::boyer_moore;
+            return search_strategy::horspool;
+            }
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator horspool_search ( RandomAccessIterator curPos, RandomAccessIterator corpus_last ) const {
+            const RandomAccessIterator lastPos = corpus_last - k_pattern_length;
+            while ( curPos <= lastPos ) {
+                difference_type j = k_pattern_length - 1;
+                while ( pred_ ( pattern_ [ j ], curPos [ j ] )) {
+                    if ( j == 0 )
+                        return curPos;
+                    --j;
+                    }
+                curPos += skip_ [ curPos [ k_pattern_length - 1 ]];
+                }
+            return corpus_last;
+            }
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator kmp_search ( RandomAccessIterator curPos, RandomAccessIterator corpus_last ) const {
+            const std::size_t m = pattern_.size ();
+            std::size_t j = 0;      // how much of the pattern matches the elements before curPos
+            for ( ; curPos != corpus_last; ++curPos ) {
+                while ( j > 0 && !pred_ ( pattern_ [ j ], *curPos ))
+                    j = fail_ [ j - 1 ];
+                if ( pred_ ( pattern_ [ j ], *curPos ) && ++j == m )
+                    return curPos - ( m - 1 );
+                }
+            return corpus_last;
+            }
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator simd_search ( RandomAccessIterator curPos, RandomAccessIterator corpus_last, std::true_type ) const {
+            const std::size_t n = std::distance ( curPos, corpus_last );
+            if ( n < pattern_.size ())
+                return corpus_last;
+            return curPos + detail::find_integers ( &*curPos, n, pattern_.data (), pattern_.size (), detail::cpu_simd_level ());
+            }
+
+    //  Never chosen for these types; decide () only picks the filter for contiguous integers
+        template <typename RandomAccessIterator>
+        RandomAccessIterator simd_search ( RandomAccessIterator curPos, RandomAccessIterator corpus_last, std::false_type ) const {
+            return this->horspool_search ( curPos, corpus_last );
+            }
+
+    //  fail_ [i] is the length of the longest proper prefix of pattern [0, i] that is also a suffix of it
+        void build_failure_table () {
+            std::size_t k = 0;
+            for ( std::size_t i = 1; i < pattern_.size (); ++i ) {
+                while ( k > 0 && !pred_ ( pattern_ [ k ], pattern_ [ i ] ))
+                    k = fail_ [ k - 1 ];
+                if ( pred_ ( pattern_ [ k ], pattern_ [ i ] ))
+                    ++k;
+                fail_ [ i ] = k;
+                }
+            }
+        };
+
+
+template <typename ForwardIterator,
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+adaptive_searcher<ForwardIterator, Hash, BinaryPredicate> make_adaptive_searcher (
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return adaptive_searcher<ForwardIterator, Hash, BinaryPredicate> ( first, last, hash, pred );
+	}
+}
+
+#endif // TBA_ADAPTIVE_SEARCH_HPP
@@ -0,0 +1,316 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Searching an asynchronous byte source with C++20 coroutines.
+//
+//  async_search ( source, searcher, pattern_length ) returns an
+//  async_generator of the stream offsets of every match. Any searcher can be
+//  used as the matching kernel; it is run over each buffer (plus the last
+//  pattern_length - 1 bytes of the previous one, so that matches which
+//  straddle two reads are found exactly once).
+//
+//  A source is anything with a member
+//      Awaitable read ( char *buffer, std::size_t size );
+//  where co_await-ing the result gives the number of bytes read (0 at the end).
+//  If the read is started when read () is called, rather than when it is
+//  awaited, the next read overlaps with scanning the current buffer.
+//  fd_source is such a source; it runs blocking reads on an io_thread_pool,
+//  so the caller's thread is never blocked waiting for I/O.
+//
+
+#ifndef TBA_ASYNC_SEARCH_HPP
+#define TBA_ASYNC_SEARCH_HPP
+
+#include "searching.hpp"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace tba {
+
+//  A lazily started generator that may co_await between values.
+//  Consume it from a coroutine with:
+//      while ( auto v = co_await gen.next ()) use ( *v );
+    template <typename T>
+    class async_generator {
+    public:
+        struct promise_type {
+            std::optional<T> value_;
+            std::exception_ptr error_;
+            std::coroutine_handle<> consumer_;
+
+            async_generator get_return_object () {
+                return async_generator ( std::coroutine_handle<promise_type>::from_promise ( *this ));
+                }
+
+        //  Hands control back to whoever is waiting in next ()
+            struct to_consumer {
+                bool await_ready () const noexcept { return false; }
+                std::coroutine_handle<> await_suspend ( std::coroutine_handle<promise_type> h ) noexcept {
+                    return h.promise ().consumer_;
+                    }
+                void await_resume () const noexcept {}
+                };
+
+            std::suspend_always initial_suspend () const noexcept { return {}; }
+            to_consumer final_suspend () const noexcept { return {}; }
+
+            to_consumer yield_value ( T value ) {
+                value_ = std::move ( value );
+                return {};
+                }
+
+            void return_void () { value_.reset (); }
+            void unhandled_exception () { value_.reset (); error_ = std::current_exception (); }
+            };
+
+        async_generator ( async_generator &&other ) noexcept : coro_ ( std::exchange ( other.coro_, nullptr )) {}
+        async_generator ( const async_generator & ) = delete;
+        async_generator &operator = ( const async_generator & ) = delete;
+
+        ~async_generator () {
+            if ( coro_ )
+                coro_.destroy ();
+            }
+
+        struct next_awaiter {
+            std::coroutine_handle<promise_type> coro_;
+
+            bool await_ready () const noexcept { return !coro_ || coro_.done (); }
+            std::coroutine_handle<> await_suspend ( std::coroutine_handle<> consumer ) noexcept {
+                coro_.promise ().consumer_ = consumer;
+                return coro_;
+                }
+            std::optional<T> await_resume () {
+                if ( !coro_ )
+                    return std::nullopt;
+                promise_type &p = coro_.promise ();
+                if ( p.error_ )
+                    std::rethrow_exception ( std::exchange ( p.error_, nullptr ));
+                if ( coro_.done ())
+                    return std::nullopt;
+                return std::exchange ( p.value_, std::nullopt );
+                }
+            };
+
+        /// \brief Resumes the generator; the result is the next value, or nullopt at the end
+        next_awaiter next () { return next_awaiter { coro_ }; }
+
+    private:
+        explicit async_generator ( std::coroutine_handle<promise_type> coro ) : coro_ ( coro ) {}
+        std::coroutine_handle<promise_type> coro_;
+        };
+
+
+    /// \fn async_search ( Source &source, Searcher searcher, std::size_t pattern_length, std::size_t buffer_size )
+    /// \brief Yields the stream offset of every match of the searcher's pattern in the source
+    ///
+    /// \param source          The byte source; it must outlive the generator
+    /// \param searcher        The matching kernel; any searcher over char *
+    /// \param pattern_length  The length of the searcher's pattern
+    /// \param buffer_size     How much to ask the source for at a time
+    ///
+    template <typename Source, typename Searcher>
+    async_generator<std::uint64_t> async_search ( Source &source, Searcher searcher,
+                std::size_t pattern_length, std::size_t buffer_size = 64 * 1024 ) {
+        const std::size_t keep = pattern_length > 0 ? pattern_length - 1 : 0;
+        std::vector<char> current ( keep + buffer_size ), next ( keep + buffer_size );
+        std::uint64_t base = 0;         // stream offset of current [0]
+        std::size_t carried = 0;        // bytes at the front of current that came from the previous read
+
+        std::size_t n = co_await source.read ( current.data (), buffer_size );
+        while ( n > 0 ) {
+            const std::size_t valid = carried + n;
+
+        //  Start the next read before scanning, so that the two overlap
+            const std::size_t next_carried = std::min ( keep, valid );
+            std::copy ( current.begin () + ( valid - next_carried ), current.begin () + valid, next.begin ());
+            auto pending = source.read ( next.data () + next_carried, buffer_size );
+
+            const char *first = current.data ();
+            const char *last  = first + valid;
+            for ( const char *it = searcher ( first, last ); it != last; it = searcher ( it + 1, last ))
+                co_yield base + static_cast<std::uint64_t> ( it - first );
+
+            base   += valid - next_carried;
+            carried = next_carried;
+            n = co_await pending;
+            current.swap ( next );
+            }
+        }
+
+
+//  A fixed set of worker threads for running blocking calls off the caller's thread.
+//  Coroutines waiting on a job are resumed on the worker that ran it, so use at
+//  least two threads if a generator may be destroyed from inside a worker.
+    class io_thread_pool {
+    public:
+        explicit io_thread_pool ( std::size_t threads = 2 ) : stopping_ ( false ) {
+            for ( std::size_t i = 0; i < threads; ++i )
+                workers_.emplace_back ( [this] { this->run (); });
+            }
+
+        io_thread_pool ( const io_thread_pool & ) = delete;
+        io_thread_pool &operator = ( const io_thread_pool & ) = delete;
+
+        ~io_thread_pool () {
+            {
+                std::lock_guard<std::mutex> lock ( mutex_ );
+                stopping_ = true;
+            }
+            ready_.notify_all ();
+            for ( std::thread &t : workers_ )
+                t.join ();
+            }
+
+        void post ( std::function<void ()> job ) {
+            {
+                std::lock_guard<std::mutex> lock ( mutex_ );
+                jobs_.push_back ( std::move ( job ));
+            }
+            ready_.notify_one ();
+            }
+
+    private:
+        void run () {
+            for ( ;; ) {
+                std::function<void ()> job;
+                {
+                    std::unique_lock<std::mutex> lock ( mutex_ );
+                    ready_.wait ( lock, [this] { return stopping_ || !jobs_.empty (); });
+                    if ( jobs_.empty ())
+                        return;
+                    job = std::move ( jobs_.front ());
+                    jobs_.pop_front ();
+                }
+                job ();
+                }
+            }
+
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<std::function<void ()>> jobs_;
+        std::vector<std::thread> workers_;
+        bool stopping_;
+        };
+
+
+#if defined(__unix__) || defined(__APPLE__)
+//  A source that reads a file descriptor on an io_thread_pool.
+//  Each read starts as soon as read () is called; the awaiting coroutine is
+//  resumed on the pool thread that completed it.
+    class fd_source {
+        struct state {
+            std::mutex mutex_;
+            std::condition_variable done_cv_;
+            bool done_ = false;
+            std::size_t result_ = 0;
+            std::exception_ptr error_;
+            std::coroutine_handle<> waiter_;
+            };
+
+    public:
+        class read_operation {
+        public:
+            explicit read_operation ( std::shared_ptr<state> st ) : state_ ( std::move ( st )) {}
+            read_operation ( read_operation && ) = default;
+
+        //  The read writes into a buffer the caller owns, so never let go of it while in flight
+            ~read_operation () {
+                if ( state_ ) {
+                    std::unique_lock<std::mutex> lock ( state_->mutex_ );
+                    state_->done_cv_.wait ( lock, [this] { return state_->done_; });
+                    }
+                }
+
+            bool await_ready () const noexcept {
+                std::lock_guard<std::mutex> lock ( state_->mutex_ );
+                return state_->done_;
+                }
+
+            bool await_suspend ( std::coroutine_handle<> h ) {
+                std::lock_guard<std::mutex> lock ( state_->mutex_ );
+                if ( state_->done_ )
+                    return false;
+                state_->waiter_ = h;
+                return true;
+                }
+
+            std::size_t await_resume () {
+                if ( state_->error_ )
+                    std::rethrow_exception ( state_->error_ );
+                return state_->result_;
+                }
+
+        private:
+            std::shared_ptr<state> state_;
+            };
+
+        fd_source ( int fd, io_thread_pool &pool ) : fd_ ( fd ), pool_ ( pool ) {}
+
+        read_operation read ( char *buffer, std::size_t size ) {
+            std::shared_ptr<state> st = std::make_shared<state> ();
+            const int fd = fd_;
+            pool_.post ( [st, fd, buffer, size] {
+                std::size_t total = 0;
+                std::exception_ptr error;
+            //  Fill the buffer unless we hit the end; short reads are common on pipes
+                while ( total < size ) {
+                    const ssize_t n = ::read ( fd, buffer + total, size - total );
+                    if ( n < 0 && errno == EINTR )
+                        continue;
+                    if ( n < 0 ) {
+                        error = std::make_exception_ptr ( std::system_error ( errno, std::generic_category (), "fd_source: read" ));
+                        break;
+                        }
+                    if ( n == 0 )
+                        break;
+                    total += static_cast<std::size_t> ( n );
+                    }
+
+                std::coroutine_handle<> waiter;
+                {
+                    std::lock_guard<std::mutex> lock ( st->mutex_ );
+                    st->result_ = total;
+                    st->error_  = error;
+                    st->done_   = true;
+                    waiter = st->waiter_;
+                }
+                st->done_cv_.notify_all ();
+                if ( waiter )
+                    waiter.resume ();
+                });
+            return read_operation ( std::move ( st ));
+            }
+
+    private:
+        int fd_;
+        io_thread_pool &pool_;
+        };
+#endif
+}
+
+#endif // __cpp_impl_coroutine
+
+#endif // TBA_ASYNC_SEARCH_HPP
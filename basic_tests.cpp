@@ -6,9 +6,34 @@
 */
 
 #include "searching.hpp"
+#include "searcher_image.hpp"
+#include "suffix_array.hpp"
+#include "qgram_index.hpp"
+#include "async_search.hpp"
+#include "packed_dna.hpp"
+#include "search_cursor.hpp"
+#include "segmented_search.hpp"
+#include "wildcard_search.hpp"
+#include "integer_search.hpp"
+#include "multi_search.hpp"
+#include "adaptive_search.hpp"
+#include "incremental_search.hpp"
+#include "block_summary.hpp"
+
+#if defined(TBA_SIMD_DISPATCH) || defined(TBA_TARGET_AVX2) || defined(TBA_TARGET_AVX512)
+#error "integer_search.hpp must not export its dispatch macros"
+#endif
 
 #include <string>
 #include <iostream>
+#include <sstream>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <thread>
+#include <list>
+#include <deque>
+#include <functional>
 
 template <typename T>
 struct my_equals {
@@ -44,7 +69,21 @@ size_t cihash ( char one ) {
 		iter_type it1  = tba::search ( hBeg, hEnd, tba::make_searcher ( nBeg, nEnd ));
 		iter_type it2  = tba::search ( hBeg, hEnd, tba::make_searcher ( nBeg, nEnd, my_equals<typename Container::value_type>()));
 		iter_type it3  = tba::search ( hBeg, hEnd, tba::make_boyer_moore_searcher ( nBeg, nEnd ));
-//		iter_type it4  = tba::search ( hBeg, hEnd, tba::make_boyer_moore_horspool_searcher ( nBeg, nEnd ));
+		iter_type it5  = tba::search ( hBeg, hEnd, tba::make_owning_searcher ( nBeg, nEnd ));
+	//	Build from a non-contiguous pattern that is gone before the search happens
+		auto owning_bm = [=] () {
+			const std::list<char> scattered ( nBeg, nEnd );
+			return tba::make_owning_boyer_moore_searcher ( scattered.begin (), scattered.end ());
+			} ();
+		iter_type it6  = tba::search ( hBeg, hEnd, owning_bm );
+		iter_type it7  = tba::search ( hBeg, hEnd, tba::make_bndm_searcher ( nBeg, nEnd ));
+		iter_type it8  = tba::search ( hBeg, hEnd, tba::make_backward_oracle_searcher ( nBeg, nEnd ));
+		iter_type it9  = tba::search ( hBeg, hEnd, tba::make_rabin_karp_searcher ( nBeg, nEnd ));
+		iter_type it10 = tba::search ( hBeg, hEnd, tba::make_adaptive_searcher ( nBeg, nEnd ));
+		iter_type it4  = tba::search ( hBeg, hEnd, tba::make_boyer_moore_horspool_searcher ( nBeg, nEnd ));
+		iter_type it11 = tba::search ( hBeg, hEnd, tba::make_sunday_searcher ( nBeg, nEnd ));
+		iter_type it12 = tba::search ( hBeg, hEnd, tba::make_raita_searcher ( nBeg, nEnd ));
+		iter_type it13 = tba::search ( hBeg, hEnd, tba::make_rare_byte_searcher ( nBeg, nEnd ));
 		const typename std::iterator_traits<iter_type>::difference_type dist = it1 == hEnd ? -1 : std::distance ( hBeg, it1 );
 
 //		std::cout << "(Iterators) Pattern is " << needle.length () << ", haysstack is " << haystack.length () << " chars long; " << std::endl;
@@ -64,10 +103,55 @@ size_t cihash ( char one ) {
 					std::string ( "results mismatch between std::search and tba::search (bm_searcher)" ));
 				}
 
-//			if ( it0 != it4 ) {
-//				throw std::runtime_error ( 
-//					std::string ( "results mismatch between std::search and tba::search (bmh_searcher)" ));
-//				}
+			if ( it0 != it5 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (owning_searcher)" ));
+				}
+
+			if ( it0 != it6 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (owning bm_searcher)" ));
+				}
+
+			if ( it0 != it7 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (bndm_searcher)" ));
+				}
+
+			if ( it0 != it8 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (backward_oracle_searcher)" ));
+				}
+
+			if ( it0 != it9 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (rabin_karp_searcher)" ));
+				}
+
+			if ( it0 != it10 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (adaptive_searcher)" ));
+				}
+
+			if ( it0 != it4 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (bmh_searcher)" ));
+				}
+
+			if ( it0 != it11 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (sunday_searcher)" ));
+				}
+
+			if ( it0 != it12 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (raita_searcher)" ));
+				}
+
+			if ( it0 != it13 ) {
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (rare_byte_searcher)" ));
+				}
 			}
 
 		catch ( ... ) {
@@ -77,7 +161,16 @@ size_t cihash ( char one ) {
 			std::cout << "	tba:	  " << std::distance ( hBeg, it1 ) << "\n";
 			std::cout << "	tba(red): " << std::distance ( hBeg, it2 ) << "\n";
 			std::cout << "	bm:	      " << std::distance ( hBeg, it3 ) << "\n";
-//			std::cout << "	bmh:      " << std::distance ( hBeg, it4 ) << "\n";
+			std::cout << "	owning:   " << std::distance ( hBeg, it5 ) << "\n";
+			std::cout << "	own bm:   " << std::distance ( hBeg, it6 ) << "\n";
+			std::cout << "	bndm:     " << std::distance ( hBeg, it7 ) << "\n";
+			std::cout << "	bom:      " << std::distance ( hBeg, it8 ) << "\n";
+			std::cout << "	rk:       " << std::distance ( hBeg, it9 ) << "\n";
+			std::cout << "	adaptive: " << std::distance ( hBeg, it10 ) << "\n";
+			std::cout << "	bmh:      " << std::distance ( hBeg, it4 ) << "\n";
+			std::cout << "	sunday:   " << std::distance ( hBeg, it11 ) << "\n";
+			std::cout << "	raita:    " << std::distance ( hBeg, it12 ) << "\n";
+			std::cout << "	rare:     " << std::distance ( hBeg, it13 ) << "\n";
 			std::cout << std::flush;
 			throw ;
 			}
@@ -87,8 +180,724 @@ size_t cihash ( char one ) {
 		}
 
 
+//	Check that load_boyer_moore refuses a damaged image, for the expected reason
+	void check_image_rejected ( const std::vector<std::uint64_t> &bad, std::size_t size, const std::string &reason ) {
+		try {
+			tba::load_boyer_moore ( bad.data (), size );
+			}
+		catch ( const std::runtime_error &e ) {
+			if ( std::string ( e.what ()).find ( reason ) != std::string::npos )
+				return;
+			throw std::runtime_error ( std::string ( "bad image rejected for the wrong reason: " ) + e.what ());
+			}
+		throw std::runtime_error ( std::string ( "bad image was loaded; expected " ) + reason );
+		}
+
+//	Replaces one 8-byte word of the image
+	std::vector<std::uint64_t> with_word ( std::vector<std::uint64_t> image, std::size_t word, std::uint64_t value ) {
+		image [ word ] = value;
+		return image;
+		}
+
+//	Check that a saved and reloaded Boyer-Moore image finds the same thing
+	template<typename Container>
+	void check_one_image ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		iter_type hBeg = haystack.begin ();
+		iter_type hEnd = haystack.end ();
+
+		std::ostringstream out;
+		if ( needle.empty ()) {
+			bool threw = false;
+			try { tba::save ( out, tba::make_boyer_moore_searcher ( needle.begin (), needle.end ())); }
+			catch ( const std::invalid_argument & ) { threw = true; }
+			if ( !threw )
+				throw std::runtime_error ( std::string ( "saved an image of an empty pattern" ));
+			return;
+			}
+		tba::save ( out, tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()));
+		const std::string bytes = out.str ();
+
+	//	Copy into a buffer with the alignment an mmapped file would have
+		std::vector<std::uint64_t> image ( bytes.size () / 8 );
+		std::memcpy ( image.data (), bytes.data (), bytes.size ());
+
+		iter_type it0 = std::search ( hBeg, hEnd, needle.begin (), needle.end ());
+		iter_type it1 = tba::search ( hBeg, hEnd, tba::load_boyer_moore ( image.data (), bytes.size ()));
+		if ( it0 != it1 ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and tba::search (bm image)" ));
+			}
+
+	//	Images that would make the searcher loop or step backwards must not load
+		const std::size_t size = bytes.size ();
+		const std::size_t skip_at = 4, suffix_at = 4 + 256;		// in 8-byte words
+		check_image_rejected ( with_word ( image, skip_at + 'A', std::uint64_t ( -1 )),               size, "corrupt skip table" );
+		check_image_rejected ( with_word ( image, skip_at + 'A', needle.size () + 1 ),                size, "corrupt skip table" );
+		check_image_rejected ( with_word ( image, suffix_at + 1, 0 ),                                 size, "corrupt suffix table" );
+		check_image_rejected ( with_word ( image, suffix_at + needle.size (), std::uint64_t ( -2 )), size, "corrupt suffix table" );
+
+	//	An image written on the other byte order has its magic number swapped
+		std::vector<std::uint64_t> foreign ( image );
+		const std::uint32_t swapped = tba::detail::image_swap32 ( tba::detail::k_image_magic );
+		std::memcpy ( foreign.data (), &swapped, sizeof ( swapped ));
+		check_image_rejected ( foreign, size, "wrong byte order" );
+		}
+
+#if defined(__unix__) || defined(__APPLE__)
+//	Check that images concatenated into a file and mapped back in all find what std::search does
+	template<typename Container>
+	void check_one_image_file ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		if ( needle.empty ()) return;
+		const std::string needles [] = { needle, std::string ( needle.rbegin (), needle.rend ()) };
+
+		char path [] = "/tmp/tba_imagesXXXXXX";
+		const int fd = ::mkstemp ( path );
+		if ( fd < 0 )
+			throw std::runtime_error ( std::string ( "cannot create a temporary file" ));
+		::close ( fd );
+		{
+			std::ofstream file ( path, std::ios::binary );
+			for ( const std::string &n : needles )
+				tba::save ( file, tba::make_boyer_moore_searcher ( n.begin (), n.end ()));
+		}
+
+		static_assert ( std::is_nothrow_move_constructible<tba::mapped_file>::value, "mapped_file moves must not throw" );
+		tba::mapped_file mapped ( path );
+		::unlink ( path );
+		const std::vector<tba::boyer_moore_image_searcher> searchers = tba::load_boyer_moore_images ( mapped.data (), mapped.size ());
+		if ( searchers.size () != 2 )
+			throw std::runtime_error ( std::string ( "wrong number of images loaded from a file" ));
+		for ( std::size_t i = 0; i < 2; ++i ) {
+			iter_type it0 = std::search ( haystack.begin (), haystack.end (), needles [ i ].begin (), needles [ i ].end ());
+			iter_type it1 = tba::search ( haystack.begin (), haystack.end (), searchers [ i ] );
+			if ( it0 != it1 ) {
+				std::cout << "Searching for: " << needles [ i ] << std::endl;
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and tba::search (mapped bm image)" ));
+				}
+			}
+		}
+#else
+	template<typename Container>
+	void check_one_image_file ( const Container &, const std::string & ) {}
+#endif
+
+
+//	Check that a suffix array index over the haystack agrees with std::search
+	template<typename Container>
+	void check_one_index ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		iter_type hBeg = haystack.begin ();
+		iter_type hEnd = haystack.end ();
+
+		auto index = tba::make_suffix_array_index ( hBeg, hEnd );
+		iter_type it0 = std::search ( hBeg, hEnd, needle.begin (), needle.end ());
+		iter_type it1 = tba::search ( hBeg, hEnd, index.searcher ( needle.begin (), needle.end ()));
+
+		std::size_t count = 0;
+		for ( iter_type it = it0; it != hEnd; it = std::search ( it + 1, hEnd, needle.begin (), needle.end ()))
+			++count;
+		if ( it0 != it1 || ( !needle.empty () && index.count ( needle.begin (), needle.end ()) != count )) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and suffix_array_index" ));
+			}
+		}
+
+
+//	Check that a q-gram index, appended to in pieces, agrees with std::search
+	template<typename Container>
+	void check_one_qgram ( const Container &haystack, const std::string &needle ) {
+		tba::qgram_index index ( 3 );
+		const std::size_t half = haystack.size () / 2;
+		index.append ( haystack.begin (), haystack.begin () + half );
+		index.append ( haystack.begin () + half, haystack.end ());
+
+		const std::size_t pos0 = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()) - haystack.begin ();
+		const std::size_t pos1 = index.find_first ( needle.begin (), needle.end ());
+		const std::size_t pos2 = index.find_first ( needle.begin (), needle.end (), tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()));
+		if ( pos0 != pos1 || pos0 != pos2 ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and qgram_index" ));
+			}
+		}
+
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+//	A source that hands out the haystack a few bytes at a time, completing immediately
+	struct chunked_source {
+		const std::string &data;
+		std::size_t pos;
+
+		struct read_op {
+			std::size_t n;
+			bool await_ready () const { return true; }
+			void await_suspend ( std::coroutine_handle<> ) const {}
+			std::size_t await_resume () const { return n; }
+			};
+
+		read_op read ( char *buffer, std::size_t size ) {
+			const std::size_t n = std::min<std::size_t> ({ size, 3, data.size () - pos });
+			std::copy ( data.begin () + pos, data.begin () + pos + n, buffer );
+			pos += n;
+			return read_op { n };
+			}
+		};
+
+	struct detached_task {
+		struct promise_type {
+			detached_task get_return_object () { return {}; }
+			std::suspend_never initial_suspend () noexcept { return {}; }
+			std::suspend_never final_suspend () noexcept { return {}; }
+			void return_void () {}
+			void unhandled_exception () { std::terminate (); }
+			};
+		};
+
+//	Collects the offsets of the first limit matches, then signals done; the
+//	coroutine may finish on another thread
+	template <typename Source>
+	detached_task collect_async ( Source &source, const std::string &needle, std::size_t buffer_size, std::size_t limit,
+	                              std::vector<std::uint64_t> &out, std::shared_ptr<std::promise<void>> done ) {
+		{
+			auto matches = tba::async_search ( source, tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()), needle.size (), buffer_size );
+			while ( out.size () < limit )
+				if ( auto pos = co_await matches.next ())
+					out.push_back ( *pos );
+				else
+					break;
+		}	// destroying matches waits for any read still in flight
+		done->set_value ();
+		}
+
+	template <typename Source>
+	std::vector<std::uint64_t> run_async ( Source &source, const std::string &needle, std::size_t buffer_size,
+	                                       std::size_t limit = std::size_t ( -1 )) {
+		std::vector<std::uint64_t> retVal;
+		std::shared_ptr<std::promise<void>> done = std::make_shared<std::promise<void>> ();
+		std::future<void> finished = done->get_future ();
+		collect_async ( source, needle, buffer_size, limit, retVal, done );
+		finished.get ();
+		return retVal;
+		}
+
+#if defined(__unix__) || defined(__APPLE__)
+//	Search a pipe through fd_source, the writer dribbling the haystack in a few
+//	bytes at a time, so that reads come back short and matches span buffers
+	std::vector<std::uint64_t> run_fd_async ( tba::io_thread_pool &pool, const std::string &haystack, const std::string &needle,
+	                                          std::size_t limit = std::size_t ( -1 )) {
+		int fds [ 2 ];
+		if ( ::pipe ( fds ) != 0 )
+			throw std::runtime_error ( std::string ( "cannot create a pipe" ));
+		std::thread writer ( [&haystack, fds] {
+			for ( std::size_t pos = 0; pos < haystack.size (); ) {
+				const ssize_t n = ::write ( fds [ 1 ], haystack.data () + pos, std::min<std::size_t> ( 3, haystack.size () - pos ));
+				if ( n <= 0 )
+					break;
+				pos += static_cast<std::size_t> ( n );
+				std::this_thread::yield ();
+				}
+			::close ( fds [ 1 ] );
+			});
+
+		std::vector<std::uint64_t> retVal;
+		{
+			tba::fd_source source ( fds [ 0 ], pool );
+			retVal = run_async ( source, needle, 7, limit );
+		}
+		writer.join ();
+		::close ( fds [ 0 ] );
+		return retVal;
+		}
+#endif
+
+//	Check that async_search, fed in small pieces, finds every match that std::search does
+	void check_one_async ( const std::string &haystack, const std::string &needle ) {
+		if ( needle.empty ()) return;
+		std::vector<std::uint64_t> expected;
+		for ( auto it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()); it != haystack.end (); 
+				   it = std::search ( it + 1, haystack.end (), needle.begin (), needle.end ()))
+			expected.push_back ( it - haystack.begin ());
+
+		chunked_source source { haystack, 0 };
+		if ( run_async ( source, needle, 5 ) != expected ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and async_search" ));
+			}
+
+#if defined(__unix__) || defined(__APPLE__)
+	//	Through a real file descriptor, resuming on the pool's threads; stopping
+	//	after the first match abandons the generator with a read outstanding
+		tba::io_thread_pool pool;
+		const std::vector<std::uint64_t> first ( expected.begin (), expected.begin () + std::min<std::size_t> ( 1, expected.size ()));
+		if ( run_fd_async ( pool, haystack, needle ) != expected || run_fd_async ( pool, haystack, needle, 1 ) != first ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and async_search (fd_source)" ));
+			}
+#endif
+		}
+#else
+	void check_one_async ( const std::string &, const std::string & ) {}
+#endif
+
+
+//	A searcher with no count member, to exercise tba::count's fallback
+	struct search_only {
+		std::string pattern;
+		template <typename Iterator>
+		Iterator operator () ( Iterator first, Iterator last ) const {
+			return std::search ( first, last, pattern.begin (), pattern.end ());
+			}
+		};
+
+//	Check tba::count, both ways, against counting with a std::search loop
+	template<typename Container>
+	void check_one_count ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		iter_type hBeg = haystack.begin ();
+		iter_type hEnd = haystack.end ();
+		const std::deque<char> hDeque ( hBeg, hEnd );	// not contiguous
+
+		const tba::count_mode modes [] = { tba::count_mode::overlapping, tba::count_mode::non_overlapping };
+		for ( tba::count_mode mode : modes ) {
+			const std::size_t step = mode == tba::count_mode::overlapping || needle.empty () ? 1 : needle.size ();
+			std::size_t expected = 0;
+			for ( iter_type it = std::search ( hBeg, hEnd, needle.begin (), needle.end ()); it != hEnd; ++expected ) {
+				if ( static_cast<std::size_t> ( hEnd - it ) < step ) break;
+				it = std::search ( it + step, hEnd, needle.begin (), needle.end ());
+				}
+			if ( needle.empty ())
+				expected = haystack.size ();
+
+			const std::size_t counts [] = {
+				tba::count ( hBeg, hEnd, tba::make_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_bndm_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_backward_oracle_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_rabin_karp_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_boyer_moore_horspool_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_sunday_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_raita_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hBeg, hEnd, tba::make_rare_byte_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( hDeque.begin (), hDeque.end (), tba::make_rare_byte_searcher ( needle.begin (), needle.end ()), mode ),
+				tba::count ( haystack.data (), haystack.data () + haystack.size (), tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()), mode ),
+				mode == tba::count_mode::overlapping ? tba::count ( hBeg, hEnd, search_only { needle }, mode ) : expected
+				};
+			for ( std::size_t i = 0; i < sizeof ( counts ) / sizeof ( counts [ 0 ] ); ++i )
+				if ( counts [ i ] != expected ) {
+					std::cout << "Searching for: " << needle << "; expected " << expected << ", got " << counts [ i ] << std::endl;
+					throw std::runtime_error ( 
+						std::string ( "results mismatch between std::search and tba::count" ));
+					}
+			}
+		}
+
+
+//	Check that a search_cursor, run with tiny budgets and handed over to a new
+//	cursor part way through, finds every match that std::search does
+	template<typename Container>
+	void check_one_cursor ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		iter_type hBeg = haystack.begin ();
+		iter_type hEnd = haystack.end ();
+
+		std::vector<std::size_t> expected, found;
+		for ( iter_type it = std::search ( hBeg, hEnd, needle.begin (), needle.end ()); it != hEnd; 
+				   it = std::search ( it + 1, hEnd, needle.begin (), needle.end ()))
+			expected.push_back ( it - hBeg );
+
+		const auto bm = tba::make_boyer_moore_searcher ( needle.begin (), needle.end ());
+		auto cursor = tba::make_search_cursor ( hBeg, hEnd, std::cref ( bm ), needle.size ());
+		for ( std::size_t budget = 0; ; budget = ( budget + 1 ) % 4 ) {
+			const tba::cursor_status status = cursor.next ( budget );
+			if ( status == tba::cursor_status::end )
+				break;
+			if ( status == tba::cursor_status::found )
+				found.push_back ( cursor.match () - hBeg );
+			else if ( budget == 2 )
+				cursor = tba::make_search_cursor ( hBeg, hEnd, std::cref ( bm ), needle.size (), cursor.resume_token ());
+			}
+
+		if ( expected != found ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and search_cursor" ));
+			}
+		}
+
+
+//	Check segmented_search over the haystack cut into pieces of 1, 2, 3, 1, 2, 3, ...
+//	elements, against std::search over the whole thing
+	void check_one_segmented ( const std::string &haystack, const std::string &needle ) {
+		std::vector<std::string> segments;
+		std::vector<std::size_t> starts;
+		for ( std::size_t i = 0; i < haystack.size (); i += segments.back ().size ()) {
+			starts.push_back ( i );
+			segments.push_back ( haystack.substr ( i, segments.size () % 3 + 1 ));
+			}
+
+		std::vector<std::size_t> expected, found;
+		for ( std::string::const_iterator it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()); it != haystack.end (); 
+				   it = std::search ( it + 1, haystack.end (), needle.begin (), needle.end ()))
+			expected.push_back ( it - haystack.begin ());
+
+		const auto bm = tba::make_boyer_moore_searcher ( needle.begin (), needle.end ());
+		for ( tba::segment_position pos = tba::segmented_search ( segments.begin (), segments.end (), bm, needle.size ());
+				pos.segment != segments.size ();
+				pos = tba::segmented_search ( segments.begin (), segments.end (), bm, needle.size (), tba::segment_position { pos.segment, pos.offset + 1 }))
+			found.push_back ( starts [ pos.segment ] + pos.offset );
+
+		if ( expected != found ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and segmented_search" ));
+			}
+		}
+
+
+//	Check wildcard_searcher with the needle escaped (which must act like std::search),
+//	and with every third byte of it replaced by ?
+	void check_one_wildcard ( const std::string &haystack, const std::string &needle ) {
+		if ( needle.size () > tba::wildcard_searcher::k_max_positions ) {
+			try { tba::make_wildcard_searcher ( needle.begin (), needle.end ()); }
+			catch ( const std::length_error & ) { return; }
+			throw std::runtime_error ( std::string ( "wildcard_searcher accepted a pattern that is too long" ));
+			}
+
+		std::string escaped, wild;
+		for ( std::size_t i = 0; i < needle.size (); ++i ) {
+			escaped += '\\';
+			escaped += needle [ i ];
+			if ( i % 3 == 1 )
+				wild += '?';
+			else {
+				wild += '\\';
+				wild += needle [ i ];
+				}
+			}
+
+		std::size_t wildPos = haystack.size ();
+		for ( std::size_t s = 0; s + needle.size () <= haystack.size () && !haystack.empty (); ++s ) {
+			std::size_t i = 0;
+			while ( i < needle.size () && ( i % 3 == 1 || haystack [ s + i ] == needle [ i ] ))
+				++i;
+			if ( i == needle.size ()) { wildPos = s; break; }
+			}
+
+		const std::size_t pos0 = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()) - haystack.begin ();
+		const std::size_t pos1 = tba::search ( haystack.begin (), haystack.end (), tba::make_wildcard_searcher ( escaped.begin (), escaped.end ())) - haystack.begin ();
+		const std::size_t pos2 = tba::search ( haystack.begin (), haystack.end (), tba::make_wildcard_searcher ( wild.begin (), wild.end ())) - haystack.begin ();
+		if ( pos0 != pos1 || wildPos != pos2 ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and wildcard_searcher" ));
+			}
+		}
+
+
+//	Check rabin_karp_set_searcher with the needle, its reverse and a duplicate,
+//	against the earliest std::search result among them
+	template<typename Container>
+	void check_one_set ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		const std::string reversed ( needle.rbegin (), needle.rend ());
+		const std::vector<std::string> patterns { reversed, needle, reversed };
+
+		iter_type expected = haystack.end ();
+		std::size_t which = patterns.size ();
+		for ( std::size_t i = 0; i < patterns.size (); ++i ) {
+			iter_type it = std::search ( haystack.begin (), haystack.end (), patterns [ i ].begin (), patterns [ i ].end ());
+			if ( it != haystack.end () && ( expected == haystack.end () || it < expected )) {
+				expected = it;
+				which = i;
+				}
+			}
+
+		const auto found = tba::make_rabin_karp_set_searcher ( patterns.begin (), patterns.end ()).find ( haystack.begin (), haystack.end ());
+		if ( found.first != expected || found.second != which ) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and rabin_karp_set_searcher" ));
+			}
+		}
+
+
+//	Check packed_dna_searcher (and an ordinary searcher over packed_dna iterators)
+//	against std::search, from every starting offset. Only applies to ACGT data.
+	void check_one_packed ( const std::string &haystack, const std::string &needle ) {
+		if ( haystack.find_first_not_of ( "ACGT" ) != std::string::npos || needle.find_first_not_of ( "ACGT" ) != std::string::npos )
+			return;
+
+		const tba::packed_dna packed ( haystack );
+		const auto s = tba::make_packed_dna_searcher ( needle.begin (), needle.end ());
+		for ( std::size_t off = 0; off <= haystack.size (); ++off ) {
+			const std::size_t pos0 = std::search ( haystack.begin () + off, haystack.end (), needle.begin (), needle.end ()) - haystack.begin ();
+			const std::size_t pos1 = tba::search ( packed.begin () + off, packed.end (), s ) - packed.begin ();
+			const std::size_t pos2 = tba::search ( packed.begin () + off, packed.end (), 
+						tba::make_boyer_moore_searcher ( needle.begin (), needle.end ())) - packed.begin ();
+			const std::size_t pos3 = tba::search ( haystack.begin () + off, haystack.end (), s ) - haystack.begin ();
+			if ( pos0 != pos1 || pos0 != pos2 || pos0 != pos3 ) {
+				std::cout << "Searching for: " << needle << " from " << off << std::endl;
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and packed_dna_searcher" ));
+				}
+			}
+		}
+
+
+//	Check every strategy of adaptive_searcher (our corpora are too short for it to
+//	choose one itself) by finding all the matches with the strategy already decided,
+//	with and without a case-insensitive predicate. The searchers
+//	are built from a copy of the needle that is gone before they search.
+	template<typename Container>
+	void check_one_adaptive ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		const tba::search_strategy strategies [] = {
+			tba::search_strategy::undecided, tba::search_strategy::horspool, tba::search_strategy::boyer_moore,
+			tba::search_strategy::simd_prefilter, tba::search_strategy::linear };
+
+		std::vector<iter_type> expected, expected_ci;
+		for ( iter_type it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()); it != haystack.end (); 
+				it = std::search ( it + 1, haystack.end (), needle.begin (), needle.end ()))
+			expected.push_back ( it );
+		for ( iter_type it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end (), ciequal ); it != haystack.end (); 
+				it = std::search ( it + 1, haystack.end (), needle.begin (), needle.end (), ciequal ))
+			expected_ci.push_back ( it );
+
+		std::string *copy = new std::string ( needle );
+		const auto s    = tba::make_adaptive_searcher ( copy->begin (), copy->end ());
+		const auto s_ci = tba::make_adaptive_searcher ( copy->begin (), copy->end (), cihash, ciequal );
+		delete copy;
+		for ( tba::search_strategy strategy : strategies ) {
+			std::vector<iter_type> found, found_ci;
+			tba::adaptive_state state, state_ci;
+			state.strategy = state_ci.strategy = strategy;
+			for ( iter_type it = s.search ( haystack.begin (), haystack.end (), state ); it != haystack.end (); it = s.search ( it + 1, haystack.end (), state ))
+				found.push_back ( it );
+			for ( iter_type it = s_ci.search ( haystack.begin (), haystack.end (), state_ci ); it != haystack.end (); it = s_ci.search ( it + 1, haystack.end (), state_ci ))
+				found_ci.push_back ( it );
+			if ( found != expected || found_ci != expected_ci ) {
+				std::cout << "Searching for: " << needle << " with strategy " << static_cast<int> ( strategy ) << std::endl;
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between std::search and adaptive_searcher" ));
+				}
+			}
+		}
+
+
+//	Check multi_search, with searchers of several types and blocks of 1 to 7 elements,
+//	against each searcher run over the whole haystack on its own
+	template<typename Container>
+	void check_one_multi ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		const std::string reversed ( needle.rbegin (), needle.rend ());
+		const auto bm   = tba::make_boyer_moore_searcher ( needle.begin (), needle.end ());
+		const auto ci   = tba::make_boyer_moore_searcher ( needle.begin (), needle.end (), cihash, ciequal );
+		const auto rev  = tba::make_searcher ( reversed.begin (), reversed.end ());
+		const auto pair = tba::make_bndm_searcher ( needle.begin (), needle.begin () + std::min<std::size_t> ( 2, needle.size ()));
+		const std::function<iter_type ( iter_type, iter_type )> alone [] = { bm, ci, rev, pair };
+
+		std::vector<std::vector<iter_type>> expected;
+		std::vector<iter_type> firsts;
+		for ( const auto &s : alone ) {
+			expected.push_back ( std::vector<iter_type> ());
+			for ( iter_type it = s ( haystack.begin (), haystack.end ()); it != haystack.end (); it = s ( it + 1, haystack.end ()))
+				expected.back ().push_back ( it );
+			firsts.push_back ( expected.back ().empty () ? haystack.end () : expected.back ().front ());
+			}
+
+		for ( std::size_t block = 1; block <= 7; ++block ) {
+			tba::multi_search<iter_type> ms ( block );
+			ms.add ( bm, needle.size ());
+			ms.add ( ci, needle.size ());
+			ms.add ( rev, reversed.size ());
+			ms.add ( pair, std::min<std::size_t> ( 2, needle.size ()));
+			if ( ms.find_all ( haystack.begin (), haystack.end ()) != expected || ms.find_first ( haystack.begin (), haystack.end ()) != firsts ) {
+				std::cout << "Searching for: " << needle << " in blocks of " << block << std::endl;
+				throw std::runtime_error ( 
+					std::string ( "results mismatch between single searchers and multi_search" ));
+				}
+			}
+		}
+
+
+//	Check integer_searcher at each vector width, on the data widened to T
+//	(with every byte of each element set, so that all of its lanes are compared)
+	template<typename T, typename Container>
+	void check_one_integer ( const Container &haystack, const std::string &needle ) {
+		std::vector<T> hay, pat;
+		for ( char c : haystack ) hay.push_back ( static_cast<T> ( static_cast<unsigned char> ( c ) * 0x0101010101010101ULL ));
+		for ( char c : needle )   pat.push_back ( static_cast<T> ( static_cast<unsigned char> ( c ) * 0x0101010101010101ULL ));
+
+		const tba::simd_level levels [] = { tba::simd_level::scalar, tba::simd_level::avx2, tba::simd_level::avx512 };
+		for ( tba::simd_level level : levels ) {
+			const auto s = tba::make_integer_searcher ( pat.begin (), pat.end (), level );
+			for ( std::size_t off = 0; off <= hay.size (); ++off ) {
+				const std::size_t pos0 = std::search ( hay.begin () + off, hay.end (), pat.begin (), pat.end ()) - hay.begin ();
+				const std::size_t pos1 = tba::search ( hay.begin () + off, hay.end (), s ) - hay.begin ();
+				const std::size_t pos2 = tba::search ( hay.data () + off, hay.data () + hay.size (), s ) - hay.data ();
+				if ( pos0 != pos1 || pos0 != pos2 ) {
+					std::cout << "Searching for: " << needle << " from " << off << " with " << sizeof ( T ) << " byte elements" << std::endl;
+					throw std::runtime_error ( 
+						std::string ( "results mismatch between std::search and integer_searcher" ));
+					}
+				}
+			}
+		}
+
+	static_assert ( tba::detail::is_contiguous_integers<std::vector<std::uint64_t>::const_iterator>::value
+	             && tba::detail::is_contiguous_integers<std::u16string::iterator>::value
+	             && tba::detail::is_contiguous_integers<const std::uint32_t *>::value
+	             && !tba::detail::is_contiguous_integers<std::list<std::uint16_t>::iterator>::value
+	             && !tba::detail::is_contiguous_integers<std::vector<std::string>::iterator>::value,
+	        "integer_searcher only reads contiguous integers directly" );
+
+	template<typename Container>
+	void check_one_integer ( const Container &haystack, const std::string &needle ) {
+		check_one_integer<std::uint8_t>  ( haystack, needle );
+		check_one_integer<std::uint16_t> ( haystack, needle );
+		check_one_integer<std::uint32_t> ( haystack, needle );
+		check_one_integer<std::uint64_t> ( haystack, needle );
+		}
+
+
+//	Type the needle into an incremental_searcher one element at a time, then
+//	delete it again, checking every match of every prefix against std::search.
+//	A limit of one candidate makes it rescan where it would otherwise narrow.
+	template<typename Searcher, typename Container, typename Pred>
+	void check_incremental_prefix ( Searcher &s, const Container &haystack, Pred pred ) {
+		typedef typename Container::const_iterator iter_type;
+		const std::vector<char> &pattern = s.pattern ();
+		std::vector<iter_type> expected, found;
+		if ( !pattern.empty ())
+			for ( iter_type it = std::search ( haystack.begin (), haystack.end (), pattern.begin (), pattern.end (), pred ); it != haystack.end (); 
+					it = std::search ( it + 1, haystack.end (), pattern.begin (), pattern.end (), pred ))
+				expected.push_back ( it );
+		for ( iter_type it = s.find_next ( haystack.begin ()); it != haystack.end () && !pattern.empty (); it = s.find_next ( it + 1 ))
+			found.push_back ( it );
+		if ( found != expected || ( !pattern.empty () && s.count () != expected.size ())
+				|| s ( haystack.begin (), haystack.end ()) != std::search ( haystack.begin (), haystack.end (), pattern.begin (), pattern.end (), pred )) {
+			std::cout << "Searching for: " << std::string ( pattern.begin (), pattern.end ()) << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and incremental_searcher" ));
+			}
+		}
+
+	template<typename Container>
+	void check_one_incremental ( const Container &haystack, const std::string &needle ) {
+		for ( std::size_t limit : { std::size_t ( 1 ), tba::incremental_searcher<typename Container::const_iterator>::k_default_max_candidates }) {
+			tba::incremental_searcher<typename Container::const_iterator> s ( haystack.begin (), haystack.end (), limit );
+			tba::incremental_searcher<typename Container::const_iterator, size_t (*)( char ), bool (*)( char, char )>
+				s_ci ( haystack.begin (), haystack.end (), limit, cihash, ciequal );
+			for ( char c : needle ) {
+				s.push_back ( c );
+				s_ci.push_back ( c );
+				check_incremental_prefix ( s, haystack, std::equal_to<char> ());
+				check_incremental_prefix ( s_ci, haystack, ciequal );
+				}
+			while ( !s.empty ()) {
+				s.pop_back ();
+				s_ci.pop_back ();
+				check_incremental_prefix ( s, haystack, std::equal_to<char> ());
+				check_incremental_prefix ( s_ci, haystack, ciequal );
+				}
+
+		//	Replace the pattern, keeping part of it, as a search box does
+			s.assign ( needle.begin (), needle.end ());
+			s.assign ( needle.begin (), needle.begin () + needle.size () / 2 );
+			check_incremental_prefix ( s, haystack, std::equal_to<char> ());
+			s.assign ( needle.rbegin (), needle.rend ());
+			check_incremental_prefix ( s, haystack, std::equal_to<char> ());
+			}
+		}
+
+//	Check block_summary with blocks small enough that matches cross several of them,
+//	and filters small enough to say no now and then; the summary is fed in pieces,
+//	and is either complete or a few bytes behind the corpus
+	template<typename Container>
+	void check_one_summary ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		std::vector<iter_type> expected;
+		for ( iter_type it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ()); it != haystack.end (); 
+				it = std::search ( it + 1, haystack.end (), needle.begin (), needle.end ()))
+			expected.push_back ( it );
+
+		for ( std::size_t block_bytes : { 1, 2, 3, 7, 16, 1024 })
+			for ( std::size_t behind : { 0, 3 }) {
+				tba::block_summary summary ( block_bytes, 64 );
+				const std::size_t summarized = haystack.size () - std::min ( behind, haystack.size ());
+				for ( std::size_t pos = 0; pos < summarized; pos += 5 )
+					summary.append ( haystack.begin () + pos, haystack.begin () + std::min ( summarized, pos + 5 ));
+
+				const std::vector<iter_type> found = summary.find_all ( haystack.begin (), haystack.end (), needle.begin (), needle.end ());
+				const iter_type first = summary.find_first ( haystack.begin (), haystack.end (), needle.begin (), needle.end (),
+																tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()));
+				if ( found != expected || first != ( expected.empty () ? haystack.end () : expected.front ())) {
+					std::cout << "Searching for: " << needle << " in blocks of " << block_bytes << std::endl;
+					throw std::runtime_error ( 
+						std::string ( "results mismatch between std::search and block_summary" ));
+					}
+				}
+		}
+
+//	Check boyer_moore_searcher with the perfect hash skip table, over chars (with
+//	and without a case-insensitive predicate) and over string tokens
+	template<typename Container>
+	void check_one_perfect_hash ( const Container &haystack, const std::string &needle ) {
+		typedef typename Container::const_iterator iter_type;
+		typedef std::string::const_iterator needle_iter;
+		typedef tba::perfect_hash_BM_traits<needle_iter, std::hash<char>, std::equal_to<char>> traits;
+		typedef tba::perfect_hash_BM_traits<needle_iter, size_t (*)( char ), bool (*)( char, char )> ci_traits;
+
+		const auto s    = tba::make_boyer_moore_searcher<needle_iter, std::hash<char>, std::equal_to<char>, traits> ( needle.begin (), needle.end ());
+		const auto s_ci = tba::make_boyer_moore_searcher<needle_iter, size_t (*)( char ), bool (*)( char, char ), ci_traits> ( 
+								needle.begin (), needle.end (), cihash, ciequal );
+		const iter_type it0    = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ());
+		const iter_type it0_ci = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end (), ciequal );
+
+		std::vector<std::string> tokens, needle_tokens;
+		for ( char c : haystack ) tokens.push_back ( std::string ( 1, c ) + "-token" );
+		for ( char c : needle )   needle_tokens.push_back ( std::string ( 1, c ) + "-token" );
+		typedef std::vector<std::string>::const_iterator token_iter;
+		const auto s_tok = tba::make_boyer_moore_searcher<token_iter, std::hash<std::string>, std::equal_to<std::string>,
+								tba::perfect_hash_BM_traits<token_iter, std::hash<std::string>, std::equal_to<std::string>>> (
+									needle_tokens.cbegin (), needle_tokens.cend ());
+		const token_iter tok = s_tok ( tokens.cbegin (), tokens.cend ());
+
+		if ( s ( haystack.begin (), haystack.end ()) != it0 || s_ci ( haystack.begin (), haystack.end ()) != it0_ci
+				|| tok - tokens.cbegin () != it0 - haystack.begin ()) {
+			std::cout << "Searching for: " << needle << std::endl;
+			throw std::runtime_error ( 
+				std::string ( "results mismatch between std::search and boyer_moore_searcher (perfect hash)" ));
+			}
+		}
+
+
 	template<typename Container>
 	void check_one ( const Container &haystack, const std::string &needle, int expected ) {
+		check_one_image ( haystack, needle );
+		check_one_image_file ( haystack, needle );
+		check_one_index ( haystack, needle );
+		check_one_qgram ( haystack, needle );
+		check_one_async ( haystack, needle );
+		check_one_packed ( haystack, needle );
+		check_one_set ( haystack, needle );
+		check_one_count ( haystack, needle );
+		check_one_cursor ( haystack, needle );
+		check_one_segmented ( haystack, needle );
+		check_one_wildcard ( haystack, needle );
+		check_one_integer ( haystack, needle );
+		check_one_multi ( haystack, needle );
+		check_one_adaptive ( haystack, needle );
+		check_one_incremental ( haystack, needle );
+		check_one_summary ( haystack, needle );
+		check_one_perfect_hash ( haystack, needle );
 		check_one_iter ( haystack, needle, expected );
 		check_one_iter ( haystack, needle, expected, cihash, ciequal );
 		}
@@ -143,5 +952,12 @@ int main ( int, char ** ) {
 	const std::string mikhail_corpus = std::string (8, 'a') + mikhail_pattern;
 
 	check_one ( mikhail_corpus, mikhail_pattern, 8 );
+
+//	The same pattern in an all-nucleotide corpus, repeated so that matches land at
+//	every alignment within a packed word.
+	const std::string dna_corpus = std::string ( 37, 'A' ) + mikhail_pattern + "CA" + mikhail_pattern;
+	check_one ( dna_corpus, mikhail_pattern, 37 );
+	check_one ( dna_corpus, mikhail_pattern.substr ( 0, 20 ), 37 );
+	check_one ( dna_corpus, "ACTACTACTAC", 295 );
 	return 0;
 	}
@@ -0,0 +1,271 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Per-block bigram summaries, so that repeated searches of an append-only
+//  byte corpus (a log file, say) can skip the blocks that cannot match.
+//
+//  A block_summary splits the corpus into fixed-size blocks (64KB by default)
+//  and keeps, for each block, a bloom filter (4096 bits by default) of the
+//  byte bigrams that start in it. The corpus itself is not copied; the
+//  summary is fed the same bytes as they are appended, and costs
+//  filter_bits / 8 bytes per block.
+//
+//  To search, the bigrams of the pattern are looked up in the filters:
+//
+//    * a match that lies inside one block has all of its bigrams in that
+//      block's filter;
+//    * a match that crosses into the following blocks has all of its bigrams
+//      in the union of their filters.
+//
+//  Only the windows that pass are given to the searcher (which must match
+//  the pattern exactly, byte for byte). Windows that run past the end of what
+//  has been summarized are always searched, so the corpus may be ahead of its
+//  summary.
+//
+//  The filters only help when a pattern has bigrams that are rare in the
+//  corpus; a block with thousands of distinct bigrams (random bytes, or
+//  base64) fills its filter, and nothing is skipped.
+//
+
+#ifndef TBA_BLOCK_SUMMARY_HPP
+#define TBA_BLOCK_SUMMARY_HPP
+
+#include "searching.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace tba {
+
+    class block_summary {
+    public:
+        static const std::size_t k_default_block_bytes = 64 * 1024;
+        static const std::size_t k_default_filter_bits = 4096;
+
+        /// \param block_bytes  The size of the blocks that are summarized (and skipped) as a whole
+        /// \param filter_bits  The size of each block's filter; a power of two, at least 64
+        ///
+        explicit block_summary ( std::size_t block_bytes = k_default_block_bytes, std::size_t filter_bits = k_default_filter_bits )
+                : k_block_bytes ( block_bytes ), k_words ( filter_bits / 64 ), k_shift ( 32 ), size_ ( 0 ), last_ ( 0 ) {
+            if ( block_bytes == 0 )
+                throw std::invalid_argument ( "block_summary: block_bytes must not be zero" );
+            if ( filter_bits < 64 || ( filter_bits & ( filter_bits - 1 )) != 0 )
+                throw std::invalid_argument ( "block_summary: filter_bits must be a power of two, at least 64" );
+            for ( std::size_t bits = filter_bits; bits > 1; bits >>= 1 )
+                --k_shift;
+            }
+
+        std::size_t block_bytes () const { return k_block_bytes; }
+        std::size_t filter_bits () const { return k_words * 64; }
+
+        /// \brief The number of bytes summarized so far
+        std::size_t size () const { return size_; }
+
+        /// \brief The number of blocks (the last may be partly filled)
+        std::size_t blocks () const { return filters_.size () / k_words; }
+
+        /// \brief The number of bytes used by the filters
+        std::size_t memory_usage () const { return filters_.capacity () * sizeof ( std::uint64_t ); }
+
+        /// \fn append ( InputIterator first, InputIterator last )
+        /// \brief Summarizes data appended to the corpus
+        ///
+        template <typename InputIterator>
+        void append ( InputIterator first, InputIterator last ) {
+            static_assert ( sizeof ( typename std::iterator_traits<InputIterator>::value_type ) == 1,
+                    "block_summary only summarizes byte sequences" );
+            if ( first == last )
+                return;
+            if ( size_ == 0 ) {
+                filters_.resize ( k_words, 0 );
+                last_ = static_cast<unsigned char> ( *first );
+                ++first;
+                ++size_;
+                }
+
+        //  The bigram that ends at each byte belongs to the block it starts in;
+        //  room is the number of bytes the last byte's block can still take
+            std::size_t room = k_block_bytes - 1 - ( size_ - 1 ) % k_block_bytes;
+            std::uint64_t *filter = &filters_ [ filters_.size () - k_words ];
+            unsigned char prev = last_;
+            std::size_t added = 0;
+            for ( ; first != last; ++first, ++added ) {
+                const unsigned char c = static_cast<unsigned char> ( *first );
+                const std::size_t bit = this->bit_of ( prev, c );
+                filter [ bit / 64 ] |= std::uint64_t ( 1 ) << ( bit % 64 );
+                if ( room == 0 ) {
+                    filters_.resize ( filters_.size () + k_words, 0 );
+                    filter = &filters_ [ filters_.size () - k_words ];
+                    room = k_block_bytes;
+                    }
+                --room;
+                prev = c;
+                }
+            last_ = prev;
+            size_ += added;
+            }
+
+        /// \fn candidate_blocks ( PatternIterator first, PatternIterator last ) const
+        /// \brief The number of summarized blocks in which a match of the pattern may start
+        template <typename PatternIterator>
+        std::size_t candidate_blocks ( PatternIterator first, PatternIterator last ) const {
+            std::size_t retVal = 0;
+            const std::size_t block_bytes = k_block_bytes;
+            this->candidates ( size_, first, last, [&retVal, block_bytes] ( std::size_t from, std::size_t to ) {
+                retVal += ( to - 1 ) / block_bytes - from / block_bytes + 1;
+                });
+            return retVal;
+            }
+
+        /// \fn run ( RandomAccessIterator first, RandomAccessIterator last, PatternIterator pFirst, PatternIterator pLast,
+        ///           const Searcher &s, OnMatch on_match ) const
+        /// \brief Reports every match in the corpus [first, last), skipping the windows the summary rules out
+        ///
+        /// The corpus must start with the bytes that were appended to the summary.
+        /// on_match ( match ) is called for each match, in order; returning false stops the search.
+        ///
+        template <typename RandomAccessIterator, typename PatternIterator, typename Searcher, typename OnMatch>
+        void run ( RandomAccessIterator first, RandomAccessIterator last, PatternIterator pFirst, PatternIterator pLast,
+                   const Searcher &s, OnMatch on_match ) const {
+            const std::size_t n = std::distance ( first, last );
+            const std::size_t m = std::distance ( pFirst, pLast );
+            bool stopped = false;
+            this->candidates ( n, pFirst, pLast, [first, m, &s, &on_match, &stopped] ( std::size_t from, std::size_t to ) {
+                if ( stopped )
+                    return;
+            //  Every window that starts in [from, to)
+                const RandomAccessIterator sLast = first + ( to + std::max<std::size_t> ( m, 1 ) - 1 );
+                for ( RandomAccessIterator it = s ( first + from, sLast ); it != sLast; it = s ( it + 1, sLast ))
+                    if ( !on_match ( it )) {
+                        stopped = true;
+                        return;
+                        }
+                });
+            }
+
+        /// \fn find_first ( RandomAccessIterator first, RandomAccessIterator last, PatternIterator pFirst, PatternIterator pLast,
+        ///                  const Searcher &s ) const
+        /// \brief The first match in the corpus [first, last), or last
+        template <typename RandomAccessIterator, typename PatternIterator, typename Searcher>
+        RandomAccessIterator find_first ( RandomAccessIterator first, RandomAccessIterator last,
+                                          PatternIterator pFirst, PatternIterator pLast, const Searcher &s ) const {
+            RandomAccessIterator retVal = last;
+            this->run ( first, last, pFirst, pLast, s, [&retVal] ( RandomAccessIterator it ) { retVal = it; return false; });
+            return retVal;
+            }
+
+        template <typename RandomAccessIterator, typename PatternIterator>
+        RandomAccessIterator find_first ( RandomAccessIterator first, RandomAccessIterator last,
+                                          PatternIterator pFirst, PatternIterator pLast ) const {
+            return this->find_first ( first, last, pFirst, pLast, make_searcher ( pFirst, pLast ));
+            }
+
+        /// \fn find_all ( RandomAccessIterator first, RandomAccessIterator last, PatternIterator pFirst, PatternIterator pLast,
+        ///                const Searcher &s ) const
+        /// \brief Every (possibly overlapping) match in the corpus [first, last)
+        template <typename RandomAccessIterator, typename PatternIterator, typename Searcher>
+        std::vector<RandomAccessIterator> find_all ( RandomAccessIterator first, RandomAccessIterator last,
+                                                     PatternIterator pFirst, PatternIterator pLast, const Searcher &s ) const {
+            std::vector<RandomAccessIterator> retVal;
+            this->run ( first, last, pFirst, pLast, s, [&retVal] ( RandomAccessIterator it ) { retVal.push_back ( it ); return true; });
+            return retVal;
+            }
+
+        template <typename RandomAccessIterator, typename PatternIterator>
+        std::vector<RandomAccessIterator> find_all ( RandomAccessIterator first, RandomAccessIterator last,
+                                                     PatternIterator pFirst, PatternIterator pLast ) const {
+            return this->find_all ( first, last, pFirst, pLast, make_searcher ( pFirst, pLast ));
+            }
+
+    private:
+        const std::size_t k_block_bytes;
+        const std::size_t k_words;              // 64-bit words per filter
+        unsigned k_shift;                       // 32 - log2 ( filter bits )
+        std::vector<std::uint64_t> filters_;    // blocks () filters of k_words each
+        std::size_t size_;
+        unsigned char last_;                    // the last byte appended
+
+        std::size_t bit_of ( unsigned char a, unsigned char b ) const {
+            return static_cast<std::uint32_t> ((( a << 8 ) | b ) * 0x9E3779B1u ) >> k_shift;
+            }
+
+    //  True if every bit is set in the union of the filters of blocks [first_block, last_block]
+        bool all_present ( const std::vector<std::size_t> &bits, std::size_t first_block, std::size_t last_block ) const {
+            for ( std::size_t bit : bits ) {
+                const std::uint64_t mask = std::uint64_t ( 1 ) << ( bit % 64 );
+                std::size_t b = first_block;
+                while ( b <= last_block && ( filters_ [ b * k_words + bit / 64 ] & mask ) == 0 )
+                    ++b;
+                if ( b > last_block )
+                    return false;
+                }
+            return true;
+            }
+
+    //  True if a match may start in [from, to)
+        bool may_match ( const std::vector<std::size_t> &bits, std::size_t m, std::size_t from, std::size_t to ) const {
+            if ( from >= to )
+                return false;
+        //  The bigrams of those windows start in [from, to + m - 2)
+            if ( to + m - 1 > size_ )
+                return true;        // some of them have not been summarized
+            return this->all_present ( bits, from / k_block_bytes, ( to + m - 3 ) / k_block_bytes );
+            }
+
+    //  Calls f ( from, to ) for the runs of windows, in increasing order and not
+    //  touching one another, in which a match may start in a corpus of n bytes. Each block's windows are split
+    //  into those that lie inside it and those that cross into the next blocks.
+        template <typename PatternIterator, typename F>
+        void candidates ( std::size_t n, PatternIterator pFirst, PatternIterator pLast, F f ) const {
+            const std::size_t m = std::distance ( pFirst, pLast );
+            if ( m > n || n == 0 )
+                return;
+            if ( m < 2 ) {                  // no bigrams to look for; an empty pattern matches everywhere
+                f ( 0, m == 0 ? n : n - m + 1 );
+                return;
+                }
+
+            std::vector<std::size_t> bits;
+            unsigned char prev = static_cast<unsigned char> ( *pFirst );
+            for ( PatternIterator it = std::next ( pFirst ); it != pLast; ++it ) {
+                const unsigned char c = static_cast<unsigned char> ( *it );
+                bits.push_back ( this->bit_of ( prev, c ));
+                prev = c;
+                }
+            std::sort ( bits.begin (), bits.end ());
+            bits.erase ( std::unique ( bits.begin (), bits.end ()), bits.end ());
+
+            const std::size_t windows = n - m + 1;
+            std::size_t run_from = 0, run_to = 0;   // the run of windows not yet reported
+            for ( std::size_t block = 0; block * k_block_bytes < windows; ++block ) {
+                const std::size_t from  = block * k_block_bytes;
+                const std::size_t to    = std::min ( windows, from + k_block_bytes );
+                const std::size_t split = std::max ( from, std::min ( to, from + k_block_bytes - std::min ( k_block_bytes, m - 1 )));
+
+                std::size_t keep_from = to;
+                if ( this->may_match ( bits, m, from, split ))
+                    keep_from = from;
+                else if ( this->may_match ( bits, m, split, to ))
+                    keep_from = split;
+                if ( keep_from == to )
+                    continue;
+
+                if ( keep_from != run_to ) {
+                    if ( run_from != run_to )
+                        f ( run_from, run_to );
+                    run_from = keep_from;
+                    }
+                run_to = to;
+                }
+            if ( run_from != run_to )
+                f ( run_from, run_to );
+            }
+        };
+}
+
+#endif // TBA_BLOCK_SUMMARY_HPP
@@ -0,0 +1,302 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Search-as-you-type: a searcher whose pattern grows and shrinks one element at a time.
+//
+//  Rebuilding a searcher on every keystroke recomputes all of its tables and
+//  rescans the whole corpus. An incremental_searcher is bound to one corpus
+//  and keeps, for each length of the pattern typed so far, what it knows
+//  about the matches:
+//
+//    * Every match of "abcd" starts with a match of "abc", so once the matches
+//      of a pattern are known, the matches of a longer one are found by
+//      checking the new elements at each of them; the corpus is not rescanned.
+//    * Deleting the last element goes back to the matches that were known
+//      for the shorter pattern.
+//    * The corpus is only scanned when nothing shorter is known, or when the
+//      shorter pattern matched too often to keep its matches (more than
+//      max_candidates of them). The scan is Horspool, whose bad character
+//      table is updated in O(1) per element added or removed, or the SIMD
+//      byte kernel for contiguous bytes.
+//
+//  Matches are found lazily, by find_next () and count (); push_back () and
+//  pop_back () only update the tables, so keys typed faster than the results
+//  are asked for cost nothing.
+//
+//  The corpus must not change while the searcher is in use.
+//
+
+#ifndef TBA_INCREMENTAL_SEARCH_HPP
+#define TBA_INCREMENTAL_SEARCH_HPP
+
+#include "searching.hpp"
+
+namespace tba {
+
+    template <typename RandomAccessIterator,
+              typename Hash =            typename std::hash    <typename std::iterator_traits<RandomAccessIterator>::value_type>,
+              typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+    class incremental_searcher {
+        typedef typename std::iterator_traits<RandomAccessIterator>::value_type      value_type;
+        typedef typename std::iterator_traits<RandomAccessIterator>::difference_type difference_type;
+        typedef typename BM_traits<RandomAccessIterator, Hash, BinaryPredicate>::skip_table_t skip_table_t;
+
+    //  Contiguous bytes compared with == are scanned with the SIMD byte kernel
+        typedef std::integral_constant<bool, detail::is_contiguous_bytes<RandomAccessIterator>::value
+                    && std::is_same<BinaryPredicate, std::equal_to<value_type>>::value> use_byte_kernel;
+    public:
+        static const std::size_t k_default_max_candidates = 1024 * 1024;
+
+        /// \param corpus_first, corpus_last   The corpus; it must outlive the searcher, and not change
+        /// \param max_candidates              The most matches to keep for any one pattern length
+        ///
+        incremental_searcher ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last,
+                               std::size_t max_candidates = k_default_max_candidates,
+                               Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ())
+                : first_ ( corpus_first ), corpus_length_ ( std::distance ( corpus_first, corpus_last )),
+                  max_candidates_ ( max_candidates ), pred_ ( pred ), last_seen_ ( 0, -1, hash, pred ) {}
+
+        /// \fn push_back ( const value_type &v )
+        /// \brief Adds v to the end of the pattern
+        void push_back ( const value_type &v ) {
+            pattern_.push_back ( v );
+            level lvl;
+            lvl.state = candidates::unknown;
+            lvl.saved = -1;
+        //  The previous last element now counts for the bad character table
+            const difference_type m = pattern_.size ();
+            if ( m >= 2 ) {
+                lvl.saved = last_seen_ [ pattern_ [ m - 2 ]];
+                last_seen_.insert ( pattern_ [ m - 2 ], m - 2 );
+                }
+            levels_.push_back ( std::move ( lvl ));
+            }
+
+        /// \fn pop_back ()
+        /// \brief Removes the last element of the pattern, which must not be empty
+        void pop_back () {
+            const difference_type m = pattern_.size ();
+            if ( m >= 2 )
+                last_seen_.insert ( pattern_ [ m - 2 ], levels_.back ().saved );
+            levels_.pop_back ();
+            pattern_.pop_back ();
+            }
+
+        /// \fn assign ( ForwardIterator first, ForwardIterator last )
+        /// \brief Replaces the pattern, keeping what is known about the prefix it shares with the old one
+        ///
+        /// The shared prefix is compared with the predicate, and keeps the elements it had.
+        ///
+        template <typename ForwardIterator>
+        void assign ( ForwardIterator first, ForwardIterator last ) {
+            std::size_t common = 0;
+            for ( ; common < pattern_.size () && first != last && pred_ ( pattern_ [ common ], *first ); ++common, ++first )
+                ;
+            while ( pattern_.size () > common )
+                this->pop_back ();
+            for ( ; first != last; ++first )
+                this->push_back ( *first );
+            }
+
+        /// \brief Empties the pattern
+        void clear () { while ( !pattern_.empty ()) this->pop_back (); }
+
+        std::size_t size  () const { return pattern_.size (); }
+        bool        empty () const { return pattern_.empty (); }
+        const std::vector<value_type> &pattern () const { return pattern_; }
+
+        /// \fn find_next ( RandomAccessIterator from )
+        /// \brief The first match in the corpus that starts at or after from, or the end of the corpus
+        RandomAccessIterator find_next ( RandomAccessIterator from ) {
+            const std::size_t start = std::distance ( first_, from );
+            if ( pattern_.empty ())
+                return from;
+            if ( this->resolve ()) {
+                const std::vector<std::size_t> &offsets = levels_.back ().offsets;
+                const std::vector<std::size_t>::const_iterator it = std::lower_bound ( offsets.begin (), offsets.end (), start );
+                return first_ + ( it == offsets.end () ? corpus_length_ : *it );
+                }
+
+            std::size_t retVal = corpus_length_;
+            this->scan ( start, [&retVal] ( std::size_t pos ) { retVal = pos; return false; }, use_byte_kernel ());
+            return first_ + retVal;
+            }
+
+        /// \fn count ()
+        /// \brief The number of (overlapping) matches in the corpus
+        std::size_t count () {
+            if ( pattern_.empty ())
+                return corpus_length_;      // as many as a search loop would visit
+            if ( this->resolve ())
+                return levels_.back ().offsets.size ();
+
+            return this->count_all ( use_byte_kernel ());
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches any corpus for the current pattern, with Horspool; the matches are not kept
+        ///
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename CorpusIterator>
+        CorpusIterator operator () ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<value_type>::type,
+                    typename std::decay<typename std::iterator_traits<CorpusIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( pattern_.empty ())            return corpus_first; // empty pattern matches at start
+
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( static_cast<std::size_t> ( std::distance ( corpus_first, corpus_last )) < pattern_.size ())
+                return corpus_last;
+
+            CorpusIterator retVal = corpus_last;
+            this->horspool ( corpus_first, corpus_last, [&retVal] ( CorpusIterator it ) { retVal = it; return false; });
+            return retVal;
+            }
+
+    private:
+        enum class candidates { unknown, known, too_many };
+
+    //  What is known about the matches of the first i + 1 elements of the pattern
+        struct level {
+            candidates state;
+            std::vector<std::size_t> offsets;   // the matches, if they are known
+            difference_type saved;              // the bad character entry this element's push_back replaced
+            };
+
+        RandomAccessIterator first_;
+        std::size_t corpus_length_;
+        std::size_t max_candidates_;
+        BinaryPredicate pred_;
+        std::vector<value_type> pattern_;
+        std::vector<level> levels_;
+        skip_table_t last_seen_;    // the last position of each element in pattern_ [0, m - 1), or -1
+
+    //  Works out the matches of the current pattern, if there are few enough of
+    //  them to keep. Returns true if they are in levels_.back ().offsets.
+        bool resolve () {
+            level &top = levels_.back ();
+            if ( top.state != candidates::unknown )
+                return top.state == candidates::known;
+
+            const std::size_t m = pattern_.size ();
+            std::size_t base = levels_.size () - 1;
+            while ( base > 0 && levels_ [ base - 1 ].state != candidates::known )
+                --base;
+
+            if ( base > 0 ) {
+            //  Keep the matches of the prefix that go on to match the rest of the pattern
+                for ( std::size_t pos : levels_ [ base - 1 ].offsets ) {
+                    if ( corpus_length_ - pos < m )
+                        break;
+                    std::size_t i = base;
+                    while ( i < m && pred_ ( pattern_ [ i ], first_ [ pos + i ] ))
+                        ++i;
+                    if ( i == m )
+                        top.offsets.push_back ( pos );
+                    }
+                top.state = candidates::known;
+                return true;
+                }
+
+            const std::size_t limit = max_candidates_;
+            std::vector<std::size_t> &offsets = top.offsets;
+            this->scan ( 0, [&offsets, limit] ( std::size_t pos ) { offsets.push_back ( pos ); return offsets.size () <= limit; },
+                         use_byte_kernel ());
+            if ( offsets.size () > limit ) {
+                std::vector<std::size_t> ().swap ( offsets );
+                top.state = candidates::too_many;
+                return false;
+                }
+            top.state = candidates::known;
+            return true;
+            }
+
+    //  Calls f ( offset ) for each match that starts at or after start, in order, until f returns false
+        template <typename F>
+        void scan ( std::size_t start, F f, std::false_type ) const {
+            if ( corpus_length_ - std::min ( start, corpus_length_ ) < pattern_.size ())
+                return;
+            const RandomAccessIterator first = first_;
+            this->horspool ( first_ + start, first_ + corpus_length_,
+                [first, &f] ( RandomAccessIterator it ) { return f ( static_cast<std::size_t> ( it - first )); });
+            }
+
+        template <typename F>
+        void scan ( std::size_t start, F f, std::true_type ) const {
+            const std::size_t m = pattern_.size ();
+            if ( corpus_length_ - std::min ( start, corpus_length_ ) < m )
+                return;
+            const unsigned char *s = reinterpret_cast<const unsigned char *> ( &*first_ ) + start;
+            const std::size_t n = corpus_length_ - start;
+            const unsigned char *p = reinterpret_cast<const unsigned char *> ( pattern_.data ());
+            if ( m == 1 ) {
+                for ( const unsigned char *it = s; ; ++it ) {
+                    it = static_cast<const unsigned char *> ( std::memchr ( it, p [ 0 ], n - ( it - s )));
+                    if ( it == nullptr || !f ( start + ( it - s )) || it + 1 == s + n )
+                        return;
+                    }
+                }
+            detail::scan_bytes ( s, n, p, m, [start, n, &f] ( std::size_t pos ) { return f ( start + pos ) ? pos + 1 : n; });
+            }
+
+    //  Counts the matches in the whole corpus, without keeping them
+        std::size_t count_all ( std::false_type ) const {
+            std::size_t retVal = 0;
+            this->scan ( 0, [&retVal] ( std::size_t ) { ++retVal; return true; }, std::false_type ());
+            return retVal;
+            }
+
+        std::size_t count_all ( std::true_type ) const {
+            if ( corpus_length_ < pattern_.size ())
+                return 0;
+            return detail::count_bytes ( reinterpret_cast<const unsigned char *> ( &*first_ ), corpus_length_,
+                                         reinterpret_cast<const unsigned char *> ( pattern_.data ()), pattern_.size (), count_mode::overlapping );
+            }
+
+    //  Horspool over [corpus_first, corpus_last), which holds at least one window
+        template <typename CorpusIterator, typename F>
+        void horspool ( CorpusIterator corpus_first, CorpusIterator corpus_last, F f ) const {
+            const difference_type m = pattern_.size ();
+            const CorpusIterator lastPos = corpus_last - m;
+            for ( CorpusIterator curPos = corpus_first; curPos <= lastPos; ) {
+                difference_type j = m - 1;
+                while ( pred_ ( pattern_ [ j ], curPos [ j ] )) {
+                    if ( j == 0 ) {
+                        if ( !f ( curPos ))
+                            return;
+                        break;
+                        }
+                    --j;
+                    }
+                curPos += m - 1 - last_seen_ [ curPos [ m - 1 ]];
+                }
+            }
+        };
+
+/// \fn make_incremental_searcher ( RandomAccessIterator first, RandomAccessIterator last )
+/// \brief Creates an incremental_searcher over the corpus [first, last), with an empty pattern
+    template <typename RandomAccessIterator>
+    incremental_searcher<RandomAccessIterator> make_incremental_searcher ( RandomAccessIterator first, RandomAccessIterator last ) {
+        return incremental_searcher<RandomAccessIterator> ( first, last );
+        }
+
+    template <typename RandomAccessIterator, typename Hash, typename BinaryPredicate>
+    incremental_searcher<RandomAccessIterator, Hash, BinaryPredicate>
+    make_incremental_searcher ( RandomAccessIterator first, RandomAccessIterator last, Hash hash, BinaryPredicate pred ) {
+        return incremental_searcher<RandomAccessIterator, Hash, BinaryPredicate> (
+            first, last, incremental_searcher<RandomAccessIterator, Hash, BinaryPredicate>::k_default_max_candidates, hash, pred );
+        }
+}
+
+#endif // TBA_INCREMENTAL_SEARCH_HPP
@@ -0,0 +1,174 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+#include "searching.hpp"
+#include "suffix_array.hpp"
+#include "qgram_index.hpp"
+
+#include <string>
+#include <iostream>
+#include <iomanip>	// for setprecision
+#include <fstream>
+#include <chrono>
+#include <iterator>
+
+typedef std::chrono::microseconds duration;
+
+template <typename vec>
+vec ReadFromFile ( const char *name ) {
+	std::ifstream in ( name, std::ios_base::binary | std::ios_base::in );
+	vec retVal;
+	std::istream_iterator<char, char> begin(in);
+	std::istream_iterator<char, char> end;
+
+	std::copy ( begin, end, std::back_inserter ( retVal ));
+	return retVal;
+	}
+
+template <typename Container, typename Searcher>
+int OverAndOver ( const Container &haystack, Searcher && searcher ) {
+	typename Container::const_iterator ret;
+	for ( int i = 0; i < 200; ++i )
+		ret = tba::search ( haystack.begin(), haystack.end (), searcher );
+	return ret == haystack.end () ? -1 : std::distance ( haystack.begin(), ret);
+	}
+
+template <typename Container>
+duration bm_search ( const Container &haystack, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	int ret = OverAndOver ( haystack, tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( ret != expected )
+		std::cerr << "Unexpected return from boyer_moore; got " << ret << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+template <typename Container, typename Index>
+duration index_search ( const Container &haystack, const Index &index, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	int ret = OverAndOver ( haystack, index.searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( ret != expected )
+		std::cerr << "Unexpected return from suffix_array_index; got " << ret << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+template <typename Container, typename Index>
+duration index_count ( const Index &index, const Container &needle ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	std::size_t total = 0;
+	for ( int i = 0; i < 200; ++i )
+		total += index.count ( needle.begin (), needle.end ());
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( total % 200 != 0 )
+		std::cerr << "Inconsistent counts from suffix_array_index" << std::endl;
+	return elapsed;
+	}
+
+template <typename Container>
+duration qgram_search ( const tba::qgram_index &index, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	std::size_t ret;
+	for ( int i = 0; i < 200; ++i )
+		ret = index.find_first ( needle.begin (), needle.end (), tba::make_boyer_moore_searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	const int pos = ret == index.size () ? -1 : static_cast<int> ( ret );
+	if ( pos != expected )
+		std::cerr << "Unexpected return from qgram_index; got " << pos << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+template <typename T>
+double dur_pct ( T whole, T part ) { return 100 * double (part.count ()) / double (whole.count ()); }
+
+template <typename Container, typename Index>
+void check_one ( const Container &haystack, const Index &index, const tba::qgram_index &qindex, const Container &needle, int where ) {
+	int expected;
+	switch ( where ) {
+		case -2: {
+					auto it = std::search ( haystack.begin (), haystack.end (), needle.begin (), needle.end ());
+					 assert ( it != haystack.end ());
+					 expected = std::distance ( haystack.begin (), it);
+				 }
+				 break;
+
+		case -3: expected = haystack.size () - needle.size (); break;
+		default: expected = where; break;
+		}
+
+    std::cout << "Needle is " << needle.size () << " entries long\n";
+	duration bm = bm_search ( haystack, needle, expected );
+	std::cout << "Boyer-Moore search took:                " << bm.count ()    << "\t(" << dur_pct ( bm, bm ) << ")" << std::endl;
+	duration sa = index_search ( haystack, index, needle, expected );
+	std::cout << "Suffix array find_first took:           " << sa.count ()    << "\t(" << dur_pct ( bm, sa ) << ")" << std::endl;
+	duration sac = index_count ( index, needle );
+	std::cout << "Suffix array count took:                " << sac.count ()   << "\t(" << dur_pct ( bm, sac ) << ")" << std::endl;
+	duration qg = qgram_search ( qindex, needle, expected );
+	std::cout << "Q-gram find_first took:                 " << qg.count ()    << "\t(" << dur_pct ( bm, qg ) << ")" << std::endl;
+	}
+
+int main ( int argc, char *argv[] ) {
+    std::cout << std::fixed << std::setprecision(4);
+
+	typedef std::vector<char> vec;
+    vec c1  = ReadFromFile<vec> ( "data/0001.corpus" );
+
+    vec p0b { 'T', 'U', '0', 'A', 'K', 'g' };
+    vec p0e { 'A', 'A', 'A', 'A', 'A', '=' };
+    vec p0n { 'A', '0', 'z', 'q', 'T', '4' };
+    vec p0f { 'F', 'h', 'X', 'V', 'k', 'x' };
+
+    vec p1b = ReadFromFile<vec> ( "data/0001b.pat" );
+    vec p1e = ReadFromFile<vec> ( "data/0001e.pat" );
+    vec p1n = ReadFromFile<vec> ( "data/0001n.pat" );
+    vec p1f = ReadFromFile<vec> ( "data/0001f.pat" );
+
+    vec p2b = ReadFromFile<vec> ( "data/0002b.pat" );
+    vec p2e = ReadFromFile<vec> ( "data/0002e.pat" );
+    vec p2n = ReadFromFile<vec> ( "data/0002n.pat" );
+    vec p2f = ReadFromFile<vec> ( "data/0002f.pat" );
+
+    std::cout << "Corpus is " << c1.size () << " entries long\n";
+
+	auto start = std::chrono::high_resolution_clock::now ();
+	tba::suffix_array_index<vec::const_iterator> index ( c1.begin (), c1.end ());
+	duration build = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	std::cout << "Suffix array build took:                " << build.count () << std::endl;
+	std::cout << "Suffix array memory per corpus byte:    " << double ( index.memory_usage ()) / c1.size () << std::endl;
+
+	start = std::chrono::high_resolution_clock::now ();
+	tba::qgram_index qindex ( 3 );
+	qindex.append ( c1.begin (), c1.end ());
+	build = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	std::cout << "Q-gram (q=3) build took:                " << build.count () << std::endl;
+	std::cout << "Q-gram memory per corpus byte:          " << double ( qindex.memory_usage ()) / c1.size () << std::endl;
+
+	start = std::chrono::high_resolution_clock::now ();
+	for ( int i = 0; i < 200; ++i )
+		(void) tba::make_boyer_moore_searcher ( p2b.begin (), p2b.end ());
+	duration bm_build = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	std::cout << "Boyer-Moore build (x200, 10K) took:     " << bm_build.count () << std::endl;
+
+    std::cout << "--- Beginning ---" << std::endl;
+    check_one ( c1, index, qindex, p0b, 0 );       //  Find it at position zero
+    check_one ( c1, index, qindex, p1b, 0 );
+    check_one ( c1, index, qindex, p2b, 0 );
+    std::cout << "---- Middle -----" << std::endl;
+    check_one ( c1, index, qindex, p0f, -2 );      //  Don't know answer
+    check_one ( c1, index, qindex, p1f, -2 );
+    check_one ( c1, index, qindex, p2f, -2 );
+    std::cout << "------ End ------" << std::endl;
+    check_one ( c1, index, qindex, p0e, -3 );		// at the end
+    check_one ( c1, index, qindex, p1e, -3 );
+    check_one ( c1, index, qindex, p2e, -3 );
+    std::cout << "--- Not found ---" << std::endl;
+    check_one ( c1, index, qindex, p0n, -1 );      //  Not found
+    check_one ( c1, index, qindex, p1n, -1 );
+    check_one ( c1, index, qindex, p2n, -1 );
+
+	return 0;
+	}
@@ -0,0 +1,293 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Searching sequences of 16, 32 and 64-bit integers with SIMD compares.
+//
+//  For element types wider than a byte, BM_traits falls back to a hashed skip
+//  table, and each probe of it costs more than just comparing the elements.
+//  integer_searcher instead broadcasts the first and last pattern elements,
+//  compares them against a whole vector of windows at once (32 bytes with
+//  AVX2, 64 with AVX-512), and checks the windows that match both ends with
+//  vector compares of the rest of the pattern.
+//
+//  The instruction set is picked at run time, once, with __builtin_cpu_supports,
+//  so the header does not need to be compiled with -mavx2; where that is not
+//  available (other compilers and architectures), or for corpora that are not
+//  contiguous, the search is scalar.
+//
+
+#ifndef TBA_INTEGER_SEARCH_HPP
+#define TBA_INTEGER_SEARCH_HPP
+
+#include "searching.hpp"
+
+#if ( defined(__GNUC__) || defined(__clang__)) && ( defined(__x86_64__) || defined(__i386__))
+#define TBA_SIMD_DISPATCH 1
+#include <immintrin.h>
+#define TBA_TARGET_AVX2     __attribute__ (( target ( "avx2" )))
+#define TBA_TARGET_AVX512   __attribute__ (( target ( "avx512f,avx512bw" )))
+#else
+#define TBA_SIMD_DISPATCH 0
+#endif
+
+namespace tba {
+
+//  The widest vectors integer_searcher may use; the searcher uses the smaller
+//  of this and what the processor supports.
+    enum class simd_level { scalar, avx2, avx512 };
+
+namespace detail {
+    inline simd_level detect_simd_level () {
+#if TBA_SIMD_DISPATCH
+        __builtin_cpu_init ();
+        if ( __builtin_cpu_supports ( "avx512f" ) && __builtin_cpu_supports ( "avx512bw" ))
+            return simd_level::avx512;
+        if ( __builtin_cpu_supports ( "avx2" ))
+            return simd_level::avx2;
+#endif
+        return simd_level::scalar;
+        }
+
+    inline simd_level cpu_simd_level () {
+        static const simd_level level = detect_simd_level ();
+        return level;
+        }
+
+//  True for iterators over contiguous elements, which the kernels can read directly.
+//  Only the standard strings are named, since char_traits exists only for character types.
+    template <typename Iterator, bool /*isInteger*/>
+    struct is_contiguous_integers_helper : std::false_type {};
+
+    template <typename Iterator>
+    struct is_contiguous_integers_helper<Iterator, true> : std::integral_constant<bool,
+               std::is_pointer<Iterator>::value
+            || std::is_same<Iterator, typename std::vector<typename std::iterator_traits<Iterator>::value_type>::iterator>::value
+            || std::is_same<Iterator, typename std::vector<typename std::iterator_traits<Iterator>::value_type>::const_iterator>::value
+            || std::is_same<Iterator, std::string::iterator>::value
+            || std::is_same<Iterator, std::string::const_iterator>::value
+            || std::is_same<Iterator, std::wstring::iterator>::value
+            || std::is_same<Iterator, std::wstring::const_iterator>::value
+            || std::is_same<Iterator, std::u16string::iterator>::value
+            || std::is_same<Iterator, std::u16string::const_iterator>::value
+            || std::is_same<Iterator, std::u32string::iterator>::value
+            || std::is_same<Iterator, std::u32string::const_iterator>::value> {};
+
+    template <typename Iterator, typename value_type = typename std::iterator_traits<Iterator>::value_type>
+    struct is_contiguous_integers : is_contiguous_integers_helper<Iterator,
+            std::is_integral<value_type>::value && !std::is_same<value_type, bool>::value> {};
+
+//  Each kernel returns the offset of the first occurrence of p [0, m) in s [0, n),
+//  or n if there is none; 1 <= m <= n.
+    template <typename T>
+    std::size_t find_integers_scalar ( const T *s, std::size_t n, const T *p, std::size_t m ) {
+        const T first = p [ 0 ];
+        const T last  = p [ m - 1 ];
+        for ( std::size_t i = 0; i + m <= n; ++i )
+            if ( s [ i ] == first && s [ i + m - 1 ] == last && ( m <= 2 || std::equal ( p + 1, p + m - 1, s + i + 1 )))
+                return i;
+        return n;
+        }
+
+#if TBA_SIMD_DISPATCH
+    typedef std::integral_constant<std::size_t, 2> lanes16;
+    typedef std::integral_constant<std::size_t, 4> lanes32;
+    typedef std::integral_constant<std::size_t, 8> lanes64;
+
+    TBA_TARGET_AVX2 inline __m256i broadcast_avx2 ( std::uint64_t v, lanes16 ) { return _mm256_set1_epi16 ( static_cast<short> ( v )); }
+    TBA_TARGET_AVX2 inline __m256i broadcast_avx2 ( std::uint64_t v, lanes32 ) { return _mm256_set1_epi32 ( static_cast<int> ( v )); }
+    TBA_TARGET_AVX2 inline __m256i broadcast_avx2 ( std::uint64_t v, lanes64 ) { return _mm256_set1_epi64x ( static_cast<long long> ( v )); }
+
+    TBA_TARGET_AVX2 inline __m256i equal_avx2 ( __m256i a, __m256i b, lanes16 ) { return _mm256_cmpeq_epi16 ( a, b ); }
+    TBA_TARGET_AVX2 inline __m256i equal_avx2 ( __m256i a, __m256i b, lanes32 ) { return _mm256_cmpeq_epi32 ( a, b ); }
+    TBA_TARGET_AVX2 inline __m256i equal_avx2 ( __m256i a, __m256i b, lanes64 ) { return _mm256_cmpeq_epi64 ( a, b ); }
+
+//  Whether a [0, bytes) == b [0, bytes)
+    TBA_TARGET_AVX2 inline bool equal_bytes_avx2 ( const char *a, const char *b, std::size_t bytes ) {
+        std::size_t i = 0;
+        for ( ; i + 32 <= bytes; i += 32 )
+            if ( _mm256_movemask_epi8 ( _mm256_cmpeq_epi8 (
+                        _mm256_loadu_si256 ( reinterpret_cast<const __m256i *> ( a + i )),
+                        _mm256_loadu_si256 ( reinterpret_cast<const __m256i *> ( b + i )))) != -1 )
+                return false;
+        return std::memcmp ( a + i, b + i, bytes - i ) == 0;
+        }
+
+    template <typename T>
+    TBA_TARGET_AVX2 std::size_t find_integers_avx2 ( const T *s, std::size_t n, const T *p, std::size_t m ) {
+        typedef std::integral_constant<std::size_t, sizeof ( T )> width;
+        const std::size_t k_lanes = 32 / sizeof ( T );
+    //  movemask gives a bit per byte; keep the lowest one of each lane
+        const std::uint32_t k_lane_bits = sizeof ( T ) == 2 ? 0x55555555U : sizeof ( T ) == 4 ? 0x11111111U : 0x01010101U;
+        const __m256i first = broadcast_avx2 ( static_cast<std::uint64_t> ( p [ 0 ] ), width ());
+        const __m256i last  = broadcast_avx2 ( static_cast<std::uint64_t> ( p [ m - 1 ] ), width ());
+        const char *middle = reinterpret_cast<const char *> ( p + 1 );
+        const std::size_t middle_bytes = m > 2 ? ( m - 2 ) * sizeof ( T ) : 0;
+
+        std::size_t i = 0;
+        for ( ; i + k_lanes + m - 1 <= n; i += k_lanes ) {
+            const __m256i a = _mm256_loadu_si256 ( reinterpret_cast<const __m256i *> ( s + i ));
+            const __m256i b = _mm256_loadu_si256 ( reinterpret_cast<const __m256i *> ( s + i + m - 1 ));
+            std::uint32_t mask = static_cast<std::uint32_t> ( _mm256_movemask_epi8 (
+                        _mm256_and_si256 ( equal_avx2 ( a, first, width ()), equal_avx2 ( b, last, width ())))) & k_lane_bits;
+            for ( ; mask != 0; mask &= mask - 1 ) {
+                const std::size_t pos = i + lowest_bit ( mask ) / sizeof ( T );
+                if ( equal_bytes_avx2 ( reinterpret_cast<const char *> ( s + pos + 1 ), middle, middle_bytes ))
+                    return pos;
+                }
+            }
+        const std::size_t rest = find_integers_scalar ( s + i, n - i, p, m );
+        return rest == n - i ? n : i + rest;
+        }
+
+    TBA_TARGET_AVX512 inline __m512i broadcast_avx512 ( std::uint64_t v, lanes16 ) { return _mm512_set1_epi16 ( static_cast<short> ( v )); }
+    TBA_TARGET_AVX512 inline __m512i broadcast_avx512 ( std::uint64_t v, lanes32 ) { return _mm512_set1_epi32 ( static_cast<int> ( v )); }
+    TBA_TARGET_AVX512 inline __m512i broadcast_avx512 ( std::uint64_t v, lanes64 ) { return _mm512_set1_epi64 ( static_cast<long long> ( v )); }
+
+//  AVX-512 compares give a bit per lane directly
+    TBA_TARGET_AVX512 inline std::uint64_t equal_avx512 ( __m512i a, __m512i b, lanes16 ) { return _mm512_cmpeq_epi16_mask ( a, b ); }
+    TBA_TARGET_AVX512 inline std::uint64_t equal_avx512 ( __m512i a, __m512i b, lanes32 ) { return _mm512_cmpeq_epi32_mask ( a, b ); }
+    TBA_TARGET_AVX512 inline std::uint64_t equal_avx512 ( __m512i a, __m512i b, lanes64 ) { return _mm512_cmpeq_epi64_mask ( a, b ); }
+
+    TBA_TARGET_AVX512 inline bool equal_bytes_avx512 ( const char *a, const char *b, std::size_t bytes ) {
+        std::size_t i = 0;
+        for ( ; i + 64 <= bytes; i += 64 )
+            if ( _mm512_cmpneq_epi8_mask ( _mm512_loadu_si512 ( a + i ), _mm512_loadu_si512 ( b + i )) != 0 )
+                return false;
+    //  The tail is compared with a masked load, so nothing past the end is read
+        const __mmask64 tail = bytes - i == 0 ? 0 : ~__mmask64 ( 0 ) >> ( 64 - ( bytes - i ));
+        return _mm512_mask_cmpneq_epi8_mask ( tail, _mm512_maskz_loadu_epi8 ( tail, a + i ), _mm512_maskz_loadu_epi8 ( tail, b + i )) == 0;
+        }
+
+    template <typename T>
+    TBA_TARGET_AVX512 std::size_t find_integers_avx512 ( const T *s, std::size_t n, const T *p, std::size_t m ) {
+        typedef std::integral_constant<std::size_t, sizeof ( T )> width;
+        const std::size_t k_lanes = 64 / sizeof ( T );
+        const __m512i first = broadcast_avx512 ( static_cast<std::uint64_t> ( p [ 0 ] ), width ());
+        const __m512i last  = broadcast_avx512 ( static_cast<std::uint64_t> ( p [ m - 1 ] ), width ());
+        const char *middle = reinterpret_cast<const char *> ( p + 1 );
+        const std::size_t middle_bytes = m > 2 ? ( m - 2 ) * sizeof ( T ) : 0;
+
+        std::size_t i = 0;
+        for ( ; i + k_lanes + m - 1 <= n; i += k_lanes ) {
+            const __m512i a = _mm512_loadu_si512 ( s + i );
+            const __m512i b = _mm512_loadu_si512 ( s + i + m - 1 );
+            for ( std::uint64_t mask = equal_avx512 ( a, first, width ()) & equal_avx512 ( b, last, width ()); mask != 0; mask &= mask - 1 ) {
+                const std::size_t pos = i + static_cast<std::size_t> ( __builtin_ctzll ( mask ));
+                if ( equal_bytes_avx512 ( reinterpret_cast<const char *> ( s + pos + 1 ), middle, middle_bytes ))
+                    return pos;
+                }
+            }
+        const std::size_t rest = find_integers_scalar ( s + i, n - i, p, m );
+        return rest == n - i ? n : i + rest;
+        }
+#endif
+
+    template <typename T>
+    std::size_t find_integers ( const T *s, std::size_t n, const T *p, std::size_t m, simd_level, std::true_type ) {
+        return find_bytes ( reinterpret_cast<const unsigned char *> ( s ), n, reinterpret_cast<const unsigned char *> ( p ), m );
+        }
+
+    template <typename T>
+    std::size_t find_integers ( const T *s, std::size_t n, const T *p, std::size_t m, simd_level level, std::false_type ) {
+#if TBA_SIMD_DISPATCH
+        if ( level == simd_level::avx512 )
+            return find_integers_avx512 ( s, n, p, m );
+        if ( level == simd_level::avx2 )
+            return find_integers_avx2 ( s, n, p, m );
+#else
+        (void) level;
+#endif
+        return find_integers_scalar ( s, n, p, m );
+        }
+
+    template <typename T>
+    std::size_t find_integers ( const T *s, std::size_t n, const T *p, std::size_t m, simd_level level ) {
+    //  Bytes already have a kernel of their own
+        return find_integers ( s, n, p, m, level, std::integral_constant<bool, sizeof ( T ) == 1> ());
+        }
+    }
+
+    template <typename ForwardIterator>
+    class integer_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::value_type pattern_type;
+        static_assert ( std::is_integral<pattern_type>::value && !std::is_same<pattern_type, bool>::value,
+                "integer_searcher only searches sequences of integers" );
+        static_assert ( sizeof ( pattern_type ) == 1 || sizeof ( pattern_type ) == 2 || sizeof ( pattern_type ) == 4 || sizeof ( pattern_type ) == 8,
+                "integer_searcher only searches 8, 16, 32 and 64-bit integers" );
+    public:
+        /// \param first, last  The pattern; it is copied
+        /// \param limit        The widest vectors to use; lower it to compare the kernels
+        ///
+        integer_searcher ( ForwardIterator first, ForwardIterator last, simd_level limit = simd_level::avx512 )
+                : pattern_ ( first, last ), level_ ( std::min ( limit, detail::cpu_simd_level ())) {}
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        ///
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                            typename std::remove_cv<pattern_type>::type,
+                            typename std::remove_cv<typename std::iterator_traits<RandomAccessIterator>::value_type>::type>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( pattern_.empty ())            return corpus_first; // empty pattern matches at start
+
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( static_cast<std::size_t> ( std::distance ( corpus_first, corpus_last )) < pattern_.size ())
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last,
+                std::integral_constant<bool, detail::is_contiguous_integers<RandomAccessIterator>::value> ());
+            }
+
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last,
+                            count_mode mode = count_mode::overlapping ) const {
+            return detail::count_by_search ( corpus_first, corpus_last, pattern_.size (), mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return ( *this ) ( f, l ); });
+            }
+
+        /// \brief The vectors that this searcher uses
+        simd_level level () const { return level_; }
+
+    private:
+        std::vector<pattern_type> pattern_;
+        simd_level level_;
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator do_search ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, std::true_type ) const {
+            const std::size_t n = std::distance ( corpus_first, corpus_last );
+            return corpus_first + detail::find_integers ( &*corpus_first, n, pattern_.data (), pattern_.size (), level_ );
+            }
+
+        template <typename RandomAccessIterator>
+        RandomAccessIterator do_search ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, std::false_type ) const {
+            return std::search ( corpus_first, corpus_last, pattern_.begin (), pattern_.end ());
+            }
+        };
+
+
+template <typename ForwardIterator>
+integer_searcher<ForwardIterator> make_integer_searcher ( ForwardIterator first, ForwardIterator last,
+                                                          simd_level limit = simd_level::avx512 ) {
+	return integer_searcher<ForwardIterator> ( first, last, limit );
+	}
+}
+
+//  The dispatch macros are only for this header
+#undef TBA_SIMD_DISPATCH
+#undef TBA_TARGET_AVX2
+#undef TBA_TARGET_AVX512
+
+#endif // TBA_INTEGER_SEARCH_HPP
@@ -0,0 +1,127 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Running many searchers over the same corpus in a single pass.
+//
+//  Calling tba::search once per pattern reads the whole corpus from memory
+//  once per pattern. multi_search instead walks the corpus in blocks small
+//  enough to stay in the L2 cache (256KB by default), and runs every searcher
+//  that has been added over each block before moving on to the next, so a
+//  large corpus is brought in from memory only once.
+//
+//  The searchers can be of any types (Boyer-Moore, case-insensitive,
+//  wildcard, ...), as long as they search the same kind of iterator. Each is
+//  given the windows that start in the block, so it reads pattern_length - 1
+//  elements past the block; no window is tested twice.
+//
+
+#ifndef TBA_MULTI_SEARCH_HPP
+#define TBA_MULTI_SEARCH_HPP
+
+#include "searching.hpp"
+
+#include <functional>
+
+namespace tba {
+
+    template <typename RandomAccessIterator>
+    class multi_search {
+        typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    public:
+        static const std::size_t k_default_block_bytes = 256 * 1024;
+
+        /// \param block_bytes  How much of the corpus to give every searcher at a time
+        ///
+        explicit multi_search ( std::size_t block_bytes = k_default_block_bytes )
+                : block_size_ ( std::max<std::size_t> ( block_bytes / sizeof ( value_type ), 1 )) {}
+
+        /// \fn add ( Searcher searcher, std::size_t pattern_length )
+        /// \brief Adds a searcher to the set; it is copied
+        ///
+        /// \return The searcher's id, which is its position in the results; ids count up from 0
+        ///
+        template <typename Searcher>
+        std::size_t add ( Searcher searcher, std::size_t pattern_length ) {
+            searchers_.push_back ( entry { std::function<RandomAccessIterator ( RandomAccessIterator, RandomAccessIterator )> ( searcher ),
+                                           pattern_length });
+            return searchers_.size () - 1;
+            }
+
+        /// \brief The number of searchers that have been added
+        std::size_t size () const { return searchers_.size (); }
+
+        /// \fn run ( RandomAccessIterator first, RandomAccessIterator last, OnMatch on_match )
+        /// \brief Finds the matches of every searcher in one pass over the corpus
+        ///
+        /// on_match ( id, match ) is called for every match; returning false stops that
+        /// searcher. Each searcher's matches are reported in order, but the matches
+        /// of different searchers are interleaved a block at a time.
+        ///
+        template <typename OnMatch>
+        void run ( RandomAccessIterator first, RandomAccessIterator last, OnMatch on_match ) const {
+            const std::size_t n = std::distance ( first, last );
+            std::vector<std::size_t> next ( searchers_.size (), 0 );    // the first window each searcher has not tested
+            std::vector<bool> done ( searchers_.size (), false );
+            std::size_t active = searchers_.size ();
+
+            for ( std::size_t block = 0; block < n && active > 0; block += block_size_ ) {
+                const std::size_t block_end = std::min ( n, block + block_size_ );
+                for ( std::size_t id = 0; id < searchers_.size (); ++id ) {
+                    if ( done [ id ] )
+                        continue;
+                    const entry &e = searchers_ [ id ];
+                    const std::size_t reach = std::max<std::size_t> ( e.pattern_length, 1 ) - 1;
+                    if ( n - next [ id ] < e.pattern_length ) {
+                        done [ id ] = true;
+                        --active;
+                        continue;
+                        }
+
+                //  Every window that starts in [next, block_end)
+                    const RandomAccessIterator sLast = first + std::min ( n, block_end + reach );
+                    for ( RandomAccessIterator it = e.search ( first + next [ id ], sLast ); it != sLast; it = e.search ( it + 1, sLast )) {
+                        next [ id ] = ( it - first ) + 1;
+                        if ( !on_match ( id, it )) {
+                            done [ id ] = true;
+                            --active;
+                            break;
+                            }
+                        }
+                    next [ id ] = std::max ( next [ id ], block_end );
+                    }
+                }
+            }
+
+        /// \fn find_first ( RandomAccessIterator first, RandomAccessIterator last )
+        /// \brief The first match of each searcher, or last; a searcher stops looking once it has found one
+        std::vector<RandomAccessIterator> find_first ( RandomAccessIterator first, RandomAccessIterator last ) const {
+            std::vector<RandomAccessIterator> retVal ( searchers_.size (), last );
+            this->run ( first, last, [&retVal] ( std::size_t id, RandomAccessIterator it ) { retVal [ id ] = it; return false; });
+            return retVal;
+            }
+
+        /// \fn find_all ( RandomAccessIterator first, RandomAccessIterator last )
+        /// \brief Every match of each searcher, including overlapping ones
+        std::vector<std::vector<RandomAccessIterator>> find_all ( RandomAccessIterator first, RandomAccessIterator last ) const {
+            std::vector<std::vector<RandomAccessIterator>> retVal ( searchers_.size ());
+            this->run ( first, last, [&retVal] ( std::size_t id, RandomAccessIterator it ) { retVal [ id ].push_back ( it ); return true; });
+            return retVal;
+            }
+
+    private:
+        struct entry {
+            std::function<RandomAccessIterator ( RandomAccessIterator, RandomAccessIterator )> search;
+            std::size_t pattern_length;
+            };
+
+        std::size_t block_size_;
+        std::vector<entry> searchers_;
+        };
+}
+
+#endif // TBA_MULTI_SEARCH_HPP
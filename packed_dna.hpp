@@ -0,0 +1,277 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  2-bit packed nucleotide sequences, and a searcher that works on the packed form.
+//
+//  packed_dna stores A, C, G and T in two bits each, 32 bases to a 64-bit word.
+//  Its iterators are random access and yield the bases as chars, so every
+//  searcher in searching.hpp works on it unchanged. packed_dna_searcher
+//  instead compares the pattern against the corpus a whole word (32 bases)
+//  at a time, without ever unpacking it.
+//
+
+#ifndef TBA_PACKED_DNA_HPP
+#define TBA_PACKED_DNA_HPP
+
+#include "searching.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tba {
+
+    class packed_dna {
+    public:
+        typedef char            value_type;
+        typedef std::size_t     size_type;
+        typedef std::ptrdiff_t  difference_type;
+
+        static const size_type k_bases_per_word = 32;
+
+        class const_iterator {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef char                            value_type;
+            typedef std::ptrdiff_t                  difference_type;
+            typedef const char *                    pointer;
+            typedef char                            reference;
+
+            const_iterator () : seq_ ( nullptr ), pos_ ( 0 ) {}
+            const_iterator ( const packed_dna *seq, size_type pos ) : seq_ ( seq ), pos_ ( pos ) {}
+
+            char operator *  () const { return ( *seq_ ) [ pos_ ]; }
+            char operator [] ( difference_type n ) const { return ( *seq_ ) [ pos_ + n ]; }
+
+            const_iterator &operator ++ () { ++pos_; return *this; }
+            const_iterator &operator -- () { --pos_; return *this; }
+            const_iterator  operator ++ ( int ) { const_iterator tmp = *this; ++pos_; return tmp; }
+            const_iterator  operator -- ( int ) { const_iterator tmp = *this; --pos_; return tmp; }
+            const_iterator &operator += ( difference_type n ) { pos_ += n; return *this; }
+            const_iterator &operator -= ( difference_type n ) { pos_ -= n; return *this; }
+            const_iterator  operator +  ( difference_type n ) const { return const_iterator ( seq_, pos_ + n ); }
+            const_iterator  operator -  ( difference_type n ) const { return const_iterator ( seq_, pos_ - n ); }
+            friend const_iterator operator + ( difference_type n, const const_iterator &it ) { return it + n; }
+            difference_type operator - ( const const_iterator &rhs ) const {
+                return static_cast<difference_type> ( pos_ ) - static_cast<difference_type> ( rhs.pos_ );
+                }
+
+            bool operator == ( const const_iterator &rhs ) const { return pos_ == rhs.pos_; }
+            bool operator != ( const const_iterator &rhs ) const { return pos_ != rhs.pos_; }
+            bool operator <  ( const const_iterator &rhs ) const { return pos_ <  rhs.pos_; }
+            bool operator >  ( const const_iterator &rhs ) const { return pos_ >  rhs.pos_; }
+            bool operator <= ( const const_iterator &rhs ) const { return pos_ <= rhs.pos_; }
+            bool operator >= ( const const_iterator &rhs ) const { return pos_ >= rhs.pos_; }
+
+            const packed_dna *sequence () const { return seq_; }
+            size_type position () const { return pos_; }
+
+        private:
+            const packed_dna *seq_;
+            size_type pos_;
+            };
+
+        typedef const_iterator iterator;
+
+        packed_dna () : size_ ( 0 ), words_ ( 1, 0 ) {}
+
+        template <typename InputIterator>
+        packed_dna ( InputIterator first, InputIterator last ) : size_ ( 0 ), words_ ( 1, 0 ) {
+            this->append ( first, last );
+            }
+
+        explicit packed_dna ( const std::string &bases ) : size_ ( 0 ), words_ ( 1, 0 ) {
+            this->append ( bases.begin (), bases.end ());
+            }
+
+    //  A, C, G, T (either case) map to 0..3; anything else is rejected
+        static unsigned encode ( char c ) {
+            switch ( c ) {
+                case 'A': case 'a': return 0;
+                case 'C': case 'c': return 1;
+                case 'G': case 'g': return 2;
+                case 'T': case 't': return 3;
+                default:  throw std::invalid_argument ( std::string ( "packed_dna: not a nucleotide: " ) + c );
+                }
+            }
+
+        static char decode ( unsigned code ) { return "ACGT" [ code & 3 ]; }
+
+        void push_back ( char c ) {
+            const std::uint64_t code = encode ( c );
+            words_ [ size_ / k_bases_per_word ] |= code << ( 2 * ( size_ % k_bases_per_word ));
+            ++size_;
+            if ( size_ % k_bases_per_word == 0 )
+                words_.push_back ( 0 );     // always keep a zero word past the end
+            }
+
+        template <typename InputIterator>
+        void append ( InputIterator first, InputIterator last ) {
+            for ( ; first != last; ++first )
+                this->push_back ( *first );
+            }
+
+        size_type size  () const { return size_; }
+        bool      empty () const { return size_ == 0; }
+
+        unsigned code ( size_type pos ) const {
+            return static_cast<unsigned> ( words_ [ pos / k_bases_per_word ] >> ( 2 * ( pos % k_bases_per_word ))) & 3;
+            }
+
+        char operator [] ( size_type pos ) const { return decode ( this->code ( pos )); }
+
+    //  The 32 bases starting at pos, packed into one word; bases past the end read as A.
+    //  The words vector always has a zero word past the last base, so this never reads out of bounds
+    //  for pos <= size ().
+        std::uint64_t window ( size_type pos ) const {
+            const size_type w = pos / k_bases_per_word;
+            const unsigned  s = 2 * ( pos % k_bases_per_word );
+            if ( s == 0 )
+                return words_ [ w ];
+            const std::uint64_t next = w + 1 < words_.size () ? words_ [ w + 1 ] : 0;
+            return ( words_ [ w ] >> s ) | ( next << ( 64 - s ));
+            }
+
+        const std::vector<std::uint64_t> &words () const { return words_; }
+
+        const_iterator begin () const { return const_iterator ( this, 0 ); }
+        const_iterator end   () const { return const_iterator ( this, size_ ); }
+
+    private:
+        size_type size_;
+        std::vector<std::uint64_t> words_;
+        };
+
+
+//  Searches packed_dna directly: for each corpus word, all 32 alignments are
+//  tested against the first word of the packed pattern with shifts and masks,
+//  and the candidates are then verified a word (or, with SSE2, two words) at a time.
+//  Other corpus iterators are searched with std::search as a fallback.
+    class packed_dna_searcher {
+    public:
+        template <typename ForwardIterator>
+        packed_dna_searcher ( ForwardIterator first, ForwardIterator last )
+                : pattern_ ( first, last ), bases_ ( first, last ) {
+            const std::size_t m = pattern_.size ();
+            const std::size_t full = m / packed_dna::k_bases_per_word;
+            const std::size_t rest = m % packed_dna::k_bases_per_word;
+            words_.assign ( pattern_.words ().begin (), pattern_.words ().begin () + full + ( rest ? 1 : 0 ));
+            last_mask_ = rest ? ( std::uint64_t ( 1 ) << ( 2 * rest )) - 1 : ~std::uint64_t ( 0 );
+            first_mask_ = full > 0 ? ~std::uint64_t ( 0 ) : last_mask_;
+            }
+
+        /// \fn operator ( packed_dna::const_iterator corpus_first, packed_dna::const_iterator corpus_last )
+        /// \brief Searches packed data for the pattern that was passed into the constructor
+        ///
+        packed_dna::const_iterator
+        operator () ( packed_dna::const_iterator corpus_first, packed_dna::const_iterator corpus_last ) const {
+            const std::size_t m = pattern_.size ();
+            if ( corpus_first == corpus_last ) return corpus_last;   // if nothing to search, we didn't find it!
+            if ( m == 0 )                      return corpus_first;  // empty pattern matches at start
+            if ( static_cast<std::size_t> ( corpus_last - corpus_first ) < m )
+                return corpus_last;
+
+            const packed_dna &seq = *corpus_first.sequence ();
+            const std::vector<std::uint64_t> &cw = seq.words ();
+            const std::size_t firstPos = corpus_first.position ();
+            const std::size_t lastPos  = corpus_last.position () - m;
+            const std::uint64_t first_word = words_ [ 0 ];
+
+        //  Test all 32 alignments within a corpus word at once, collecting a bit per candidate
+            for ( std::size_t w = firstPos / packed_dna::k_bases_per_word; w * packed_dna::k_bases_per_word <= lastPos; ++w ) {
+                const std::uint64_t cur  = cw [ w ];
+                const std::uint64_t next = w + 1 < cw.size () ? cw [ w + 1 ] : 0;
+                std::uint32_t hits = 0;
+                for ( unsigned s = 0; s < packed_dna::k_bases_per_word; ++s ) {
+                //  Splitting the left shift in two makes it zero (rather than undefined) when s == 0
+                    const std::uint64_t win = ( cur >> ( 2 * s )) | (( next << ( 63 - 2 * s )) << 1 );
+                    hits |= std::uint32_t ((( win ^ first_word ) & first_mask_ ) == 0 ) << s;
+                    }
+
+                const std::size_t base = w * packed_dna::k_bases_per_word;
+                if ( base < firstPos )
+                    hits &= ~std::uint32_t ( 0 ) << ( firstPos - base );
+                if ( lastPos - base < packed_dna::k_bases_per_word - 1 )
+                    hits &= ( std::uint32_t ( 2 ) << ( lastPos - base )) - 1;
+
+                for ( ; hits != 0; hits &= hits - 1 ) {
+                    const std::size_t pos = base + detail::lowest_bit ( hits );
+                    if ( this->verify ( seq, pos ))
+                        return packed_dna::const_iterator ( &seq, pos );
+                    }
+                }
+            return corpus_last;
+            }
+
+        template <typename CorpusIterator>
+        CorpusIterator operator () ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            return std::search ( corpus_first, corpus_last, bases_.begin (), bases_.end ());
+            }
+
+        std::size_t count ( packed_dna::const_iterator corpus_first, packed_dna::const_iterator corpus_last,
+                            count_mode mode = count_mode::overlapping ) const {
+            return detail::count_by_search ( corpus_first, corpus_last, pattern_.size (), mode,
+                [this] ( packed_dna::const_iterator f, packed_dna::const_iterator l ) { return ( *this ) ( f, l ); });
+            }
+
+        template <typename CorpusIterator>
+        std::size_t count ( CorpusIterator corpus_first, CorpusIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, bases_.begin (), bases_.end (), std::equal_to<char> (), mode,
+                [this] ( CorpusIterator f, CorpusIterator l ) { return std::search ( f, l, bases_.begin (), bases_.end ()); });
+            }
+
+    private:
+        packed_dna pattern_;
+        std::string bases_;
+        std::vector<std::uint64_t> words_;
+        std::uint64_t first_mask_;
+        std::uint64_t last_mask_;
+
+    //  The first word is known to match; compare the rest
+        bool verify ( const packed_dna &seq, std::size_t pos ) const {
+            const std::size_t n = words_.size ();
+            if ( n == 1 )
+                return true;
+
+            std::size_t i = 1;
+#if defined(__SSE2__)
+        //  Every word of the window has the same shift, so two can be built and compared at once
+            const std::vector<std::uint64_t> &cw = seq.words ();
+            const std::size_t base  = pos / packed_dna::k_bases_per_word;
+            const int         shift = static_cast<int> ( 2 * ( pos % packed_dna::k_bases_per_word ));
+            const __m128i right = _mm_cvtsi32_si128 ( shift );
+            const __m128i left  = _mm_cvtsi32_si128 ( 64 - shift );     // a shift of 64 gives zero
+            for ( ; i + 2 < n && base + i + 2 < cw.size (); i += 2 ) {
+                const __m128i lo  = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( &cw [ base + i ] ));
+                const __m128i hi  = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( &cw [ base + i + 1 ] ));
+                const __m128i win = _mm_or_si128 ( _mm_srl_epi64 ( lo, right ), _mm_sll_epi64 ( hi, left ));
+                const __m128i pat = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( &words_ [ i ] ));
+                if ( _mm_movemask_epi8 ( _mm_cmpeq_epi8 ( win, pat )) != 0xFFFF )
+                    return false;
+                }
+#endif
+            for ( ; i + 1 < n; ++i )
+                if ( seq.window ( pos + i * packed_dna::k_bases_per_word ) != words_ [ i ] )
+                    return false;
+            return (( seq.window ( pos + i * packed_dna::k_bases_per_word ) ^ words_ [ i ] ) & last_mask_ ) == 0;
+            }
+        };
+
+
+template <typename ForwardIterator>
+packed_dna_searcher make_packed_dna_searcher ( ForwardIterator first, ForwardIterator last ) {
+	return packed_dna_searcher ( first, last );
+	}
+}
+
+#endif // TBA_PACKED_DNA_HPP
@@ -0,0 +1,251 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  A q-gram inverted index over a growing byte corpus.
+//
+//  For every q-gram (q consecutive bytes, 1 <= q <= 4) the index keeps the
+//  sorted list of positions where it occurs, delta-encoded as varints.
+//  A query intersects the posting lists of q-grams taken from the pattern,
+//  and then verifies each surviving candidate with an ordinary searcher over
+//  a window the size of the pattern. Appending data only adds to the ends of
+//  posting lists, so the index can be kept up to date as the corpus grows.
+//
+
+#ifndef TBA_QGRAM_INDEX_HPP
+#define TBA_QGRAM_INDEX_HPP
+
+#include "searching.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tba {
+
+namespace detail {
+//  An append-only list of increasing positions, stored as varint deltas
+    class posting_list {
+    public:
+        posting_list () : last_ ( 0 ), size_ ( 0 ) {}
+
+        void push_back ( std::uint64_t pos ) {
+            assert ( size_ == 0 || pos > last_ );
+            std::uint64_t delta = size_ == 0 ? pos : pos - last_;
+            while ( delta >= 0x80 ) {
+                bytes_.push_back ( static_cast<unsigned char> ( delta | 0x80 ));
+                delta >>= 7;
+                }
+            bytes_.push_back ( static_cast<unsigned char> ( delta ));
+            last_ = pos;
+            ++size_;
+            }
+
+        std::size_t size () const { return size_; }
+        std::size_t memory_usage () const { return bytes_.capacity (); }
+
+    //  Calls f ( pos ) for each position, in increasing order
+        template <typename F>
+        void for_each ( F f ) const {
+            std::uint64_t pos = 0;
+            std::size_t i = 0;
+            while ( i < bytes_.size ()) {
+                std::uint64_t delta = 0;
+                int shift = 0;
+                while ( bytes_ [ i ] & 0x80 ) {
+                    delta |= std::uint64_t ( bytes_ [ i++ ] & 0x7f ) << shift;
+                    shift += 7;
+                    }
+                delta |= std::uint64_t ( bytes_ [ i++ ] ) << shift;
+                pos += delta;
+                f ( pos );
+                }
+            }
+
+    private:
+        std::vector<unsigned char> bytes_;
+        std::uint64_t last_;
+        std::size_t size_;
+        };
+    }
+
+
+    class qgram_index {
+    public:
+        explicit qgram_index ( std::size_t q = 3 ) : k_q ( q ), pending_ ( 0 ), last_gram_ ( 0 ) {
+            if ( q < 1 || q > 4 )
+                throw std::invalid_argument ( "qgram_index: q must be between 1 and 4" );
+            }
+
+        std::size_t q    () const { return k_q; }
+        std::size_t size () const { return corpus_.size (); }
+        const std::vector<char> &corpus () const { return corpus_; }
+
+        /// \fn append ( InputIterator first, InputIterator last )
+        /// \brief Adds data to the end of the corpus, and indexes every q-gram that is now complete
+        ///
+        template <typename InputIterator>
+        void append ( InputIterator first, InputIterator last ) {
+            static_assert ( sizeof ( typename std::iterator_traits<InputIterator>::value_type ) == 1,
+                    "qgram_index only indexes byte sequences" );
+            corpus_.insert ( corpus_.end (), first, last );
+        //  Gram codes are rolled forward from the last complete gram
+            const std::uint32_t mask = k_q == 4 ? 0xffffffffu : ( 1u << ( 8 * k_q )) - 1;
+            for ( ; pending_ + k_q <= corpus_.size (); ++pending_ ) {
+                const std::uint32_t g = pending_ == 0
+                    ? this->gram_at ( pending_ )
+                    : (( last_gram_ << 8 ) | static_cast<unsigned char> ( corpus_ [ pending_ + k_q - 1 ] )) & mask;
+                postings_ [ g ].push_back ( pending_ );
+                last_gram_ = g;
+                }
+            }
+
+        /// \fn find_all ( PatternIterator first, PatternIterator last, const Searcher &s )
+        /// \brief Returns the offsets of every (possibly overlapping) occurrence of the pattern
+        ///
+        /// \param s  A searcher for the same pattern, used to verify candidates
+        ///
+        template <typename PatternIterator, typename Searcher>
+        std::vector<std::size_t> find_all ( PatternIterator first, PatternIterator last, const Searcher &s ) const {
+            const std::size_t m = std::distance ( first, last );
+            std::vector<std::size_t> retVal;
+            typedef std::vector<char>::const_iterator corpus_iter;
+            const corpus_iter cFirst = corpus_.begin ();
+
+        //  Too short to have a q-gram; fall back to scanning with the searcher
+            if ( m < k_q ) {
+                for ( corpus_iter it = s ( cFirst, corpus_.end ()); it != corpus_.end (); it = s ( it + 1, corpus_.end ()))
+                    retVal.push_back ( it - cFirst );
+                return retVal;
+                }
+
+            std::vector<std::size_t> candidates = this->candidates ( first, m );
+            for ( std::size_t i = 0; i < candidates.size (); ++i ) {
+                const std::size_t pos = candidates [ i ];
+                if ( pos + m <= corpus_.size () && s ( cFirst + pos, cFirst + pos + m ) == cFirst + pos )
+                    retVal.push_back ( pos );
+                }
+            return retVal;
+            }
+
+        template <typename PatternIterator>
+        std::vector<std::size_t> find_all ( PatternIterator first, PatternIterator last ) const {
+            return this->find_all ( first, last, make_searcher ( first, last ));
+            }
+
+        /// \fn find_first ( PatternIterator first, PatternIterator last, const Searcher &s )
+        /// \brief Returns the offset of the first occurrence of the pattern, or size () if there is none
+        ///
+        template <typename PatternIterator, typename Searcher>
+        std::size_t find_first ( PatternIterator first, PatternIterator last, const Searcher &s ) const {
+            const std::size_t m = std::distance ( first, last );
+            if ( m < k_q )
+                return s ( corpus_.begin (), corpus_.end ()) - corpus_.begin ();
+
+            const std::vector<std::size_t> candidates = this->candidates ( first, m );
+            typedef std::vector<char>::const_iterator corpus_iter;
+            const corpus_iter cFirst = corpus_.begin ();
+            for ( std::size_t i = 0; i < candidates.size (); ++i ) {
+                const std::size_t pos = candidates [ i ];
+                if ( pos + m <= corpus_.size () && s ( cFirst + pos, cFirst + pos + m ) == cFirst + pos )
+                    return pos;
+                }
+            return corpus_.size ();
+            }
+
+        template <typename PatternIterator>
+        std::size_t find_first ( PatternIterator first, PatternIterator last ) const {
+            return this->find_first ( first, last, make_searcher ( first, last ));
+            }
+
+        /// \brief The number of bytes used by the posting lists (not counting the corpus)
+        std::size_t memory_usage () const {
+            std::size_t retVal = 0;
+            for ( auto it = postings_.begin (); it != postings_.end (); ++it )
+                retVal += sizeof ( *it ) + it->second.memory_usage ();
+            return retVal;
+            }
+
+    private:
+        static const std::size_t k_max_lists = 4;
+
+        const std::size_t k_q;
+        std::vector<char> corpus_;
+        std::size_t pending_;           // first position whose q-gram has not been indexed
+        std::uint32_t last_gram_;
+        std::unordered_map<std::uint32_t, detail::posting_list> postings_;
+
+        std::uint32_t gram_at ( std::size_t pos ) const {
+            std::uint32_t g = 0;
+            for ( std::size_t i = 0; i < k_q; ++i )
+                g = ( g << 8 ) | static_cast<unsigned char> ( corpus_ [ pos + i ] );
+            return g;
+            }
+
+        template <typename PatternIterator>
+        static std::uint32_t gram_of ( PatternIterator p, std::size_t q ) {
+            std::uint32_t g = 0;
+            for ( std::size_t i = 0; i < q; ++i, ++p )
+                g = ( g << 8 ) | static_cast<unsigned char> ( *p );
+            return g;
+            }
+
+    //  The start positions allowed by the non-overlapping q-grams of the pattern
+    //  (plus the last one). Only the shortest few posting lists are intersected;
+    //  beyond that, verifying the candidates is cheaper than decoding more lists.
+        template <typename PatternIterator>
+        std::vector<std::size_t> candidates ( PatternIterator first, std::size_t m ) const {
+            std::vector<std::pair<const detail::posting_list *, std::size_t>> lists;
+            for ( std::size_t off = 0; ; off += k_q ) {
+                if ( off + k_q > m )
+                    off = m - k_q;
+                PatternIterator p = first;
+                std::advance ( p, off );
+                auto it = postings_.find ( gram_of ( p, k_q ));
+                if ( it == postings_.end ())
+                    return std::vector<std::size_t> ();     // a q-gram that never occurs
+                lists.push_back ( std::make_pair ( &it->second, off ));
+                if ( off + k_q == m )
+                    break;
+                }
+
+            std::sort ( lists.begin (), lists.end (),
+                [] ( const std::pair<const detail::posting_list *, std::size_t> &a,
+                     const std::pair<const detail::posting_list *, std::size_t> &b ) { return a.first->size () < b.first->size (); });
+
+            if ( lists.size () > k_max_lists )
+                lists.resize ( k_max_lists );
+
+            std::vector<std::size_t> retVal, next;
+            retVal.reserve ( lists [ 0 ].first->size ());
+            const std::size_t off0 = lists [ 0 ].second;
+            lists [ 0 ].first->for_each ( [&] ( std::uint64_t pos ) {
+                if ( pos >= off0 )
+                    retVal.push_back ( static_cast<std::size_t> ( pos - off0 ));
+                });
+
+        //  Merge each further list (shifted by its offset) against the survivors
+            for ( std::size_t i = 1; i < lists.size () && !retVal.empty (); ++i ) {
+                const std::size_t off = lists [ i ].second;
+                std::size_t j = 0;
+                next.clear ();
+                lists [ i ].first->for_each ( [&] ( std::uint64_t pos ) {
+                    if ( pos < off ) return;
+                    const std::size_t start = static_cast<std::size_t> ( pos - off );
+                    while ( j < retVal.size () && retVal [ j ] < start )
+                        ++j;
+                    if ( j < retVal.size () && retVal [ j ] == start )
+                        next.push_back ( start );
+                    });
+                retVal.swap ( next );
+                }
+            return retVal;
+            }
+        };
+}
+
+#endif // TBA_QGRAM_INDEX_HPP
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <chrono>
 #include <random>
+#include <numeric>	// for accumulate
 
 #define	CORPUS_SIZE	3000000
 
@@ -45,9 +46,15 @@ template<typename Iterator>
 struct map_BM_traits {
 	typedef typename std::iterator_traits<Iterator>::difference_type value_type;
 	typedef typename std::iterator_traits<Iterator>::value_type key_type;
-	typedef tba::detail::skip_table<key_type, value_type, false> skip_table_t;
+	typedef tba::skip_table<key_type, value_type, std::hash<key_type>, std::equal_to<key_type>, false> skip_table_t;
 	};
 
+template<typename Container>
+using map_hash = std::hash<typename Container::value_type>;
+
+template<typename Container>
+using map_equal = std::equal_to<typename Container::value_type>;
+
 
 template <typename Container, typename NeedleIter>
 int OverAndOver ( const Container &haystack, NeedleIter nBegin, NeedleIter nEnd ) {
@@ -112,7 +119,8 @@ template <typename Container>
 duration bm_search_map ( const Container &haystack, const Container &needle, int expected ) {
 	auto start = std::chrono::high_resolution_clock::now ();
 	int ret = OverAndOver ( haystack, 
-	       tba::make_boyer_moore_searcher<typename Container::const_iterator, map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
+	       tba::make_boyer_moore_searcher<typename Container::const_iterator, map_hash<Container>, map_equal<Container>,
+				map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
 	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
 	if ( ret != expected )
 		std::cerr << "Unexpected return from boyer_moore(map); got " << ret << ", expected " << expected << std::endl;
@@ -138,7 +146,8 @@ template <typename Container>
 duration bmh_search_map ( const Container &haystack, const Container &needle, int expected ) {
 	auto start = std::chrono::high_resolution_clock::now ();
 	int ret = OverAndOver ( haystack, 
-	       tba::make_boyer_moore_horspool_searcher<typename Container::const_iterator, map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
+	       tba::make_boyer_moore_horspool_searcher<typename Container::const_iterator, map_hash<Container>, map_equal<Container>,
+				map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
 	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
 	if ( ret != expected )
 		std::cerr << "Unexpected return from boyer_moore(map); got " << ret << ", expected " << expected << std::endl;
@@ -279,7 +288,7 @@ void print ( int i, int j, const stats &st, double whole ) {
 	}
 	
 int main ( int argc, char *argv[] ) {
-    std::cout << std::ios::fixed << std::setprecision(4);
+    std::cout << std::fixed << std::setprecision(4);
 	int count = 3;
 	if ( argc == 2 )
 		count = std::atoi ( argv[1] );
@@ -0,0 +1,118 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  A resumable search, for callers that cannot afford to scan a whole corpus at once.
+//
+//  A search_cursor runs any searcher over the corpus a slice at a time. Each
+//  call to next () is given a budget (a number of elements, or a deadline),
+//  and stops when it finds a match, reaches the end of the corpus, or uses up
+//  its budget. In the last case, the next call picks up where this one
+//  stopped; only the pattern_length - 1 elements at the edge of a slice are
+//  read twice, and no window is ever tested twice.
+//
+//  The cursor's progress is a single offset, resume_token (), so a scan can
+//  also be continued by a new cursor, built over the same corpus with that token.
+//
+
+#ifndef TBA_SEARCH_CURSOR_HPP
+#define TBA_SEARCH_CURSOR_HPP
+
+#include "searching.hpp"
+
+#include <chrono>
+
+namespace tba {
+
+    enum class cursor_status { found, end, budget_exhausted };
+
+    template <typename RandomAccessIterator, typename Searcher>
+    class search_cursor {
+    public:
+        /// \param first, last      The corpus; it must outlive the cursor
+        /// \param searcher         The matching kernel. It is copied; pass std::ref ( s ) to share one
+        /// \param pattern_length   The length of the searcher's pattern
+        /// \param resume_token     Where to start, as returned by resume_token () of an earlier cursor
+        ///
+        search_cursor ( RandomAccessIterator first, RandomAccessIterator last, Searcher searcher,
+                        std::size_t pattern_length, std::size_t resume_token = 0 )
+            : first_ ( first ), searcher_ ( searcher ),
+              corpus_length_ ( std::distance ( first, last )), pattern_length_ ( pattern_length ),
+              pos_ ( std::min ( resume_token, corpus_length_ )), match_ ( last ) {}
+
+        /// \fn next ( std::size_t budget )
+        /// \brief Searches on, testing windows that start in at most budget elements
+        ///
+        /// \return found (see match ()), end, or budget_exhausted (call next () again to continue)
+        ///
+        cursor_status next ( std::size_t budget ) {
+            const RandomAccessIterator last = first_ + corpus_length_;
+            if ( corpus_length_ - pos_ < pattern_length_ ) {
+                pos_ = corpus_length_;
+                return cursor_status::end;
+                }
+
+        //  The slice holds every window that starts in [pos_, pos_ + budget).
+        //  (A searcher finds nothing in an empty slice, even for an empty pattern.)
+            const std::size_t span  = std::max<std::size_t> ( budget, 1 );
+            const std::size_t reach = std::max<std::size_t> ( pattern_length_, 1 ) - 1;
+            const bool        tail  = corpus_length_ - pos_ - pattern_length_ < span;
+            const std::size_t stop  = tail ? corpus_length_ : pos_ + span + reach;
+            const RandomAccessIterator sFirst = first_ + pos_;
+            const RandomAccessIterator sLast  = first_ + stop;
+
+            const RandomAccessIterator it = searcher_ ( sFirst, sLast );
+            if ( it != sLast ) {
+                match_ = it;
+                pos_   = ( it - first_ ) + 1;
+                return cursor_status::found;
+                }
+
+            match_ = last;
+            pos_   = tail ? corpus_length_ : pos_ + span;
+            return tail ? cursor_status::end : cursor_status::budget_exhausted;
+            }
+
+        /// \fn next_until ( std::chrono::time_point<Clock, Duration> deadline, std::size_t slice )
+        /// \brief Searches on until a match, the end, or the deadline
+        ///
+        /// The clock is checked after every slice elements, so the deadline may be
+        /// overrun by the time it takes to scan one slice. At least one slice is always scanned.
+        ///
+        template <typename Clock, typename Duration>
+        cursor_status next_until ( std::chrono::time_point<Clock, Duration> deadline, std::size_t slice = 64 * 1024 ) {
+            for ( ;; ) {
+                const cursor_status status = this->next ( slice );
+                if ( status != cursor_status::budget_exhausted || Clock::now () >= deadline )
+                    return status;
+                }
+            }
+
+        /// \brief The match found by the last call to next (), or the end of the corpus
+        RandomAccessIterator match () const { return match_; }
+
+        /// \brief The offset that the next call to next () will start from
+        std::size_t resume_token () const { return pos_; }
+
+    private:
+        RandomAccessIterator first_;
+        Searcher searcher_;
+        std::size_t corpus_length_;
+        std::size_t pattern_length_;
+        std::size_t pos_;               // the first window that has not been tested
+        RandomAccessIterator match_;
+        };
+
+
+template <typename RandomAccessIterator, typename Searcher>
+search_cursor<RandomAccessIterator, Searcher> make_search_cursor ( RandomAccessIterator first, RandomAccessIterator last,
+                Searcher searcher, std::size_t pattern_length, std::size_t resume_token = 0 ) {
+	return search_cursor<RandomAccessIterator, Searcher> ( first, last, searcher, pattern_length, resume_token );
+	}
+}
+
+#endif // TBA_SEARCH_CURSOR_HPP
@@ -0,0 +1,327 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Flat, position-independent images of compiled Boyer-Moore searchers.
+//
+//  An image is written once (save) and can then be searched directly out of
+//  a read-only buffer, typically an mmapped file (load_boyer_moore), without
+//  rebuilding any tables. All fields are native-endian; the header records
+//  the byte order so that a foreign image is rejected instead of misread.
+//
+//  Layout (offsets from the start of the image):
+//      image_header                         32 bytes
+//      skip table      256    x int64_t     last position of each byte in the pattern
+//      suffix table    (m+1)  x int64_t     the good-suffix shifts
+//      pattern         m      x byte        padded with zeros to a multiple of 8
+//
+//  Every image is a multiple of 8 bytes long, so several images can be
+//  concatenated into one file and loaded with load_boyer_moore_images.
+//
+
+#ifndef TBA_SEARCHER_IMAGE_HPP
+#define TBA_SEARCHER_IMAGE_HPP
+
+#include "searching.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tba {
+
+namespace detail {
+    const std::uint32_t k_image_magic      = 0x534d4254;    // "TBMS" when little-endian
+    const std::uint32_t k_image_version    = 1;
+    const std::uint32_t k_image_byte_order = 0x01020304;
+    const std::size_t   k_image_alphabet   = 256;
+
+    struct image_header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint32_t element_size;
+        std::uint64_t pattern_length;
+        std::uint64_t image_size;
+        };
+
+    static_assert ( sizeof ( image_header ) == 32, "image_header must not contain padding" );
+
+    inline std::uint32_t image_swap32 ( std::uint32_t v ) {
+        return ( v >> 24 ) | (( v >> 8 ) & 0xff00 ) | (( v << 8 ) & 0xff0000 ) | ( v << 24 );
+        }
+
+    inline std::uint64_t image_padded ( std::uint64_t n ) { return ( n + 7 ) & ~std::uint64_t ( 7 ); }
+
+    inline std::uint64_t image_size_for ( std::uint64_t pattern_length ) {
+        return sizeof ( image_header )
+             + k_image_alphabet * sizeof ( std::int64_t )
+             + ( pattern_length + 1 ) * sizeof ( std::int64_t )
+             + image_padded ( pattern_length );
+        }
+    }
+
+    struct image_access {
+        template <typename ForwardIterator, typename Hash, typename BinaryPredicate, typename Traits>
+        static void save ( std::ostream &out, const boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> &s ) {
+            typedef typename std::iterator_traits<ForwardIterator>::value_type value_type;
+            const std::uint64_t m = static_cast<std::uint64_t> ( s.k_pattern_length );
+            if ( m == 0 )
+                throw std::invalid_argument ( "searcher image: cannot save an empty pattern" );
+
+            detail::image_header h;
+            h.magic          = detail::k_image_magic;
+            h.version        = detail::k_image_version;
+            h.byte_order     = detail::k_image_byte_order;
+            h.element_size   = 1;
+            h.pattern_length = m;
+            h.image_size     = detail::image_size_for ( m );
+            out.write ( reinterpret_cast<const char *> ( &h ), sizeof ( h ));
+
+        //  Flatten the skip table into a dense one, whatever kind it is
+            for ( std::size_t i = 0; i < detail::k_image_alphabet; ++i ) {
+                const std::int64_t k = s.skip_ [ static_cast<value_type> ( i ) ];
+                out.write ( reinterpret_cast<const char *> ( &k ), sizeof ( k ));
+                }
+
+            for ( std::uint64_t i = 0; i <= m; ++i ) {
+                const std::int64_t k = s.suffix_ [ i ];
+                out.write ( reinterpret_cast<const char *> ( &k ), sizeof ( k ));
+                }
+
+            for ( ForwardIterator it = s.first_; it != s.last_; ++it ) {
+                const char c = static_cast<char> ( *it );
+                out.write ( &c, 1 );
+                }
+
+            const char zeros [ 8 ] = {};
+            out.write ( zeros, static_cast<std::streamsize> ( detail::image_padded ( m ) - m ));
+            }
+        };
+
+
+    /// \fn save ( std::ostream &out, const boyer_moore_searcher &s )
+    /// \brief Writes a flat image of the searcher's compiled tables and pattern to out
+    ///
+    /// Only byte patterns compared with std::equal_to can be saved, since the
+    /// image searcher compares raw bytes. An empty pattern has no image.
+    ///
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate, typename Traits>
+    void save ( std::ostream &out, const boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> &s ) {
+        typedef typename std::iterator_traits<ForwardIterator>::value_type value_type;
+        static_assert ( std::is_integral<value_type>::value && sizeof ( value_type ) == 1,
+                "Only byte patterns can be saved as an image" );
+        static_assert ( std::is_same<BinaryPredicate, std::equal_to<value_type>>::value,
+                "Only searchers using std::equal_to can be saved as an image" );
+        image_access::save ( out, s );
+        if ( !out )
+            throw std::runtime_error ( "searcher image: write failed" );
+        }
+
+
+//  A Boyer-Moore searcher whose tables live in an externally owned image.
+//  It does not copy anything; the image must outlive the searcher.
+    class boyer_moore_image_searcher {
+    public:
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern stored in the image
+        ///
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( sizeof ( typename std::iterator_traits<RandomAccessIterator>::value_type ) == 1,
+                    "Images can only search byte sequences" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( k_pattern_length == 0 )       return corpus_first; // empty pattern matches at start
+
+            if ( std::distance ( corpus_first, corpus_last ) < k_pattern_length )
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, pattern_, pattern_ + k_pattern_length,
+                std::equal_to<unsigned char> (), mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
+        std::size_t image_size () const { return static_cast<std::size_t> ( detail::image_size_for ( k_pattern_length )); }
+
+    private:
+        friend boyer_moore_image_searcher load_boyer_moore ( const void *data, std::size_t size );
+
+        boyer_moore_image_searcher ( const unsigned char *base, std::int64_t pattern_length )
+            : k_pattern_length ( pattern_length ),
+              skip_    ( reinterpret_cast<const std::int64_t *> ( base + sizeof ( detail::image_header ))),
+              suffix_  ( skip_ + detail::k_image_alphabet ),
+              pattern_ ( reinterpret_cast<const unsigned char *> ( suffix_ + pattern_length + 1 )) {}
+
+        std::int64_t          k_pattern_length;
+        const std::int64_t   *skip_;
+        const std::int64_t   *suffix_;
+        const unsigned char  *pattern_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
+            corpusIter curPos = corpus_first;
+            const corpusIter lastPos = corpus_last - k_pattern_length;
+            std::int64_t j, k, m;
+
+            while ( curPos <= lastPos ) {
+                j = k_pattern_length;
+                while ( pattern_ [ j - 1 ] == static_cast<unsigned char> ( curPos [ j - 1 ] )) {
+                    j--;
+                    if ( j == 0 )
+                        return curPos;
+                    }
+
+                k = skip_ [ static_cast<unsigned char> ( curPos [ j - 1 ] ) ];
+                m = j - k - 1;
+                if ( k < j && m > suffix_ [ j ] )
+                    curPos += m;
+                else
+                    curPos += suffix_ [ j ];
+                }
+
+            return corpus_last;
+            }
+        };
+
+
+    /// \fn load_boyer_moore ( const void *data, std::size_t size )
+    /// \brief Validates the image at data and returns a searcher that uses it in place
+    ///
+    /// \param data The start of the image; must be 8-byte aligned
+    /// \param size The number of bytes available at data
+    ///
+    inline boyer_moore_image_searcher load_boyer_moore ( const void *data, std::size_t size ) {
+        const unsigned char *base = static_cast<const unsigned char *> ( data );
+        if ( reinterpret_cast<std::uintptr_t> ( base ) % 8 != 0 )
+            throw std::runtime_error ( "searcher image: data is not 8-byte aligned" );
+        if ( size < sizeof ( detail::image_header ))
+            throw std::runtime_error ( "searcher image: truncated header" );
+
+        detail::image_header h;
+        std::memcpy ( &h, base, sizeof ( h ));
+    //  The magic number is written natively too, so an image from the other byte order has it swapped
+        if ( h.magic == detail::image_swap32 ( detail::k_image_magic ))
+            throw std::runtime_error ( "searcher image: wrong byte order" );
+        if ( h.magic != detail::k_image_magic )
+            throw std::runtime_error ( "searcher image: bad magic number" );
+        if ( h.byte_order != detail::k_image_byte_order )
+            throw std::runtime_error ( "searcher image: wrong byte order" );
+        if ( h.version != detail::k_image_version )
+            throw std::runtime_error ( "searcher image: unsupported version " + std::to_string ( h.version ));
+        if ( h.element_size != 1 )
+            throw std::runtime_error ( "searcher image: unsupported element size" );
+        if ( h.pattern_length > size || h.image_size != detail::image_size_for ( h.pattern_length ))
+            throw std::runtime_error ( "searcher image: corrupt header" );
+        if ( h.image_size > size )
+            throw std::runtime_error ( "searcher image: truncated image" );
+        if ( h.pattern_length == 0 )
+            throw std::runtime_error ( "searcher image: empty pattern" );
+
+    //  The searcher trusts its tables, so make sure every shift moves forward and stays in bounds
+        const std::int64_t m = static_cast<std::int64_t> ( h.pattern_length );
+        const std::int64_t *skip = reinterpret_cast<const std::int64_t *> ( base + sizeof ( detail::image_header ));
+        for ( std::size_t i = 0; i < detail::k_image_alphabet; ++i )
+            if ( skip [ i ] < 0 || skip [ i ] > m )
+                throw std::runtime_error ( "searcher image: corrupt skip table" );
+        const std::int64_t *suffix = skip + detail::k_image_alphabet;
+        for ( std::int64_t j = 1; j <= m; ++j )
+            if ( suffix [ j ] < 1 || suffix [ j ] > m )
+                throw std::runtime_error ( "searcher image: corrupt suffix table" );
+
+        return boyer_moore_image_searcher ( base, static_cast<std::int64_t> ( h.pattern_length ));
+        }
+
+    /// \fn load_boyer_moore_images ( const void *data, std::size_t size )
+    /// \brief Loads every image from a buffer holding several concatenated images
+    ///
+    inline std::vector<boyer_moore_image_searcher> load_boyer_moore_images ( const void *data, std::size_t size ) {
+        std::vector<boyer_moore_image_searcher> retVal;
+        const unsigned char *p = static_cast<const unsigned char *> ( data );
+        while ( size > 0 ) {
+            retVal.push_back ( load_boyer_moore ( p, size ));
+            const std::size_t n = retVal.back ().image_size ();
+            p    += n;
+            size -= n;
+            }
+        return retVal;
+        }
+
+
+#if defined(__unix__) || defined(__APPLE__)
+//  A read-only memory mapping of a whole file, suitable for load_boyer_moore.
+//  The mapping is page aligned, so the first image is always suitably aligned.
+    class mapped_file {
+    public:
+        explicit mapped_file ( const char *path ) : data_ ( nullptr ), size_ ( 0 ) {
+            const int fd = ::open ( path, O_RDONLY );
+            if ( fd < 0 )
+                throw std::runtime_error ( std::string ( "mapped_file: cannot open " ) + path );
+
+            struct stat st;
+            if ( ::fstat ( fd, &st ) != 0 ) {
+                ::close ( fd );
+                throw std::runtime_error ( std::string ( "mapped_file: cannot stat " ) + path );
+                }
+
+            size_ = static_cast<std::size_t> ( st.st_size );
+            if ( size_ > 0 ) {
+                void *p = ::mmap ( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+                if ( p == MAP_FAILED ) {
+                    ::close ( fd );
+                    throw std::runtime_error ( std::string ( "mapped_file: cannot map " ) + path );
+                    }
+                data_ = p;
+                }
+            ::close ( fd );
+            }
+
+        mapped_file ( mapped_file &&other ) noexcept : data_ ( other.data_ ), size_ ( other.size_ ) {
+            other.data_ = nullptr;
+            other.size_ = 0;
+            }
+
+        mapped_file ( const mapped_file & ) = delete;
+        mapped_file &operator = ( const mapped_file & ) = delete;
+
+        ~mapped_file () {
+            if ( data_ != nullptr )
+                ::munmap ( data_, size_ );
+            }
+
+        const void *data () const { return data_; }
+        std::size_t size () const { return size_; }
+
+    private:
+        void *data_;
+        std::size_t size_;
+        };
+#endif
+}
+
+#endif // TBA_SEARCHER_IMAGE_HPP
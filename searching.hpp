@@ -5,14 +5,28 @@
  http://www.boost.org/LICENSE_1_0.txt
 */
 
+#ifndef TBA_SEARCHING_HPP
+#define TBA_SEARCHING_HPP
+
 #include <algorithm>
 #include <exception>
 #include <vector>
 #include <array>
+#include <memory>
 #include <unordered_map>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
 #include <cassert>
 #include <type_traits>
 #include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace tba {
 
@@ -21,6 +35,260 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
 	return searcher ( first, last );
 	}
 
+//  How tba::count treats occurrences that overlap each other.
+//  non_overlapping counts greedily from the left, like repeatedly searching
+//  from the end of the previous match.
+    enum class count_mode { overlapping, non_overlapping };
+
+namespace detail {
+    inline unsigned lowest_bit ( std::uint32_t v ) {
+#if defined(__GNUC__)
+        return static_cast<unsigned> ( __builtin_ctz ( v ));
+#else
+        unsigned retVal = 0;
+        for ( ; ( v & 1 ) == 0; v >>= 1 )
+            ++retVal;
+        return retVal;
+#endif
+        }
+
+//  True for iterators over contiguous bytes, which the byte kernels can read directly
+    template <typename Iterator, bool /*isByte*/>
+    struct is_contiguous_bytes_helper : std::false_type {};
+
+    template <typename Iterator>
+    struct is_contiguous_bytes_helper<Iterator, true> : std::integral_constant<bool,
+               std::is_pointer<Iterator>::value
+            || std::is_same<Iterator, typename std::vector<typename std::iterator_traits<Iterator>::value_type>::iterator>::value
+            || std::is_same<Iterator, typename std::vector<typename std::iterator_traits<Iterator>::value_type>::const_iterator>::value
+            || std::is_same<Iterator, std::string::iterator>::value
+            || std::is_same<Iterator, std::string::const_iterator>::value> {};
+
+    template <typename Iterator, typename value_type = typename std::iterator_traits<Iterator>::value_type>
+    struct is_contiguous_bytes : is_contiguous_bytes_helper<Iterator,
+            std::is_integral<value_type>::value && sizeof ( value_type ) == 1 && !std::is_same<value_type, bool>::value> {};
+
+//  Calls f ( pos ) for every occurrence of p [0, m) in s [0, n), in increasing order; m >= 2.
+//  f returns the first position that may be reported next (so that matches can be
+//  skipped over); returning n or more stops the scan.
+    template <typename F>
+    void scan_bytes ( const unsigned char *s, std::size_t n, const unsigned char *p, std::size_t m, F f ) {
+        std::size_t next = 0;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+    //  Compare the first and last pattern bytes against 16 windows at once;
+    //  only windows that match both are compared in full
+        const __m128i first = _mm_set1_epi8 ( static_cast<char> ( p [ 0 ] ));
+        const __m128i last  = _mm_set1_epi8 ( static_cast<char> ( p [ m - 1 ] ));
+        for ( ; i + 16 + m - 1 <= n; i += 16 ) {
+            const __m128i a = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( s + i ));
+            const __m128i b = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( s + i + m - 1 ));
+            std::uint32_t mask = static_cast<std::uint32_t> ( _mm_movemask_epi8 (
+                        _mm_and_si128 ( _mm_cmpeq_epi8 ( a, first ), _mm_cmpeq_epi8 ( b, last ))));
+            for ( ; mask != 0; mask &= mask - 1 ) {
+                const std::size_t pos = i + lowest_bit ( mask );
+                if ( pos >= next && std::memcmp ( s + pos + 1, p + 1, m - 2 ) == 0 )
+                    if (( next = f ( pos )) >= n )
+                        return;
+                }
+            if ( next > i + 16 )
+                i = next - 16;
+            }
+#endif
+        for ( i = std::max ( i, next ); i + m <= n; ) {
+            const void *hit = std::memchr ( s + i, p [ 0 ], n - m + 1 - i );
+            if ( hit == nullptr )
+                return;
+            i = static_cast<const unsigned char *> ( hit ) - s;
+            if ( std::memcmp ( s + i + 1, p + 1, m - 1 ) != 0 )
+                ++i;
+            else if (( i = next = f ( i )) >= n )
+                return;
+            }
+        }
+
+//  The offset of the first occurrence of p [0, m) in s [0, n), or n if there is none
+    inline std::size_t find_bytes ( const unsigned char *s, std::size_t n, const unsigned char *p, std::size_t m ) {
+        if ( m == 0 ) return 0;
+        if ( m > n )  return n;
+        if ( m == 1 ) {
+            const void *hit = std::memchr ( s, p [ 0 ], n );
+            return hit == nullptr ? n : static_cast<const unsigned char *> ( hit ) - s;
+            }
+        std::size_t retVal = n;
+        scan_bytes ( s, n, p, m, [&retVal, n] ( std::size_t pos ) { retVal = pos; return n; });
+        return retVal;
+        }
+
+//  The number of times c occurs in s [0, n)
+    inline std::size_t count_byte ( const unsigned char *s, std::size_t n, unsigned char c ) {
+        std::size_t retVal = 0;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+    //  Each match subtracts -1 from a byte lane; the lanes are summed before they can overflow
+        const __m128i needle = _mm_set1_epi8 ( static_cast<char> ( c ));
+        while ( i + 16 <= n ) {
+            __m128i lanes = _mm_setzero_si128 ();
+            for ( std::size_t k = 0; k < 255 && i + 16 <= n; ++k, i += 16 )
+                lanes = _mm_sub_epi8 ( lanes, _mm_cmpeq_epi8 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( s + i )), needle ));
+            const __m128i sums = _mm_sad_epu8 ( lanes, _mm_setzero_si128 ());
+            retVal += static_cast<std::size_t> ( _mm_cvtsi128_si32 ( sums )) + static_cast<std::size_t> ( _mm_cvtsi128_si32 ( _mm_srli_si128 ( sums, 8 )));
+            }
+#endif
+        return retVal + static_cast<std::size_t> ( std::count ( s + i, s + n, c ));
+        }
+
+    inline std::size_t count_bytes ( const unsigned char *s, std::size_t n, const unsigned char *p, std::size_t m, count_mode mode ) {
+        if ( m == 0 ) return n;
+        if ( m > n )  return 0;
+        if ( m == 1 ) return count_byte ( s, n, p [ 0 ] );
+        const std::size_t step = mode == count_mode::overlapping ? 1 : m;
+        std::size_t retVal = 0;
+        scan_bytes ( s, n, p, m, [&retVal, step] ( std::size_t pos ) { ++retVal; return pos + step; });
+        return retVal;
+        }
+
+//  Counts matches by running a searcher's matching loop over what is left of the
+//  corpus after each match. search ( first, last ) is only called when the corpus
+//  is at least as long as the (non-empty) pattern.
+    template <typename Iterator, typename Search>
+    std::size_t count_by_search ( Iterator first, Iterator last, std::size_t pattern_length, count_mode mode, Search search ) {
+        std::size_t remaining = std::distance ( first, last );
+        if ( pattern_length == 0 )
+            return remaining;       // as many as a search loop would visit
+
+        const std::size_t step = mode == count_mode::overlapping ? 1 : pattern_length;
+        std::size_t retVal = 0;
+        while ( remaining >= pattern_length ) {
+            const Iterator it = search ( first, last );
+            if ( it == last )
+                break;
+            ++retVal;
+            remaining -= std::distance ( first, it ) + step;
+            first = it;
+            std::advance ( first, step );
+            }
+        return retVal;
+        }
+
+//  Short byte patterns compared with equal_to, over contiguous corpora, go to
+//  count_bytes; everything else goes through the searcher's own loop.
+    const std::size_t k_short_byte_pattern = 32;
+
+    template <typename Iterator, typename PatternIterator, typename Search>
+    std::size_t count_matches ( Iterator first, Iterator last, PatternIterator pFirst, PatternIterator pLast,
+                                count_mode mode, Search search, std::false_type ) {
+        return count_by_search ( first, last, std::distance ( pFirst, pLast ), mode, search );
+        }
+
+    template <typename Iterator, typename PatternIterator, typename Search>
+    std::size_t count_matches ( Iterator first, Iterator last, PatternIterator pFirst, PatternIterator pLast,
+                                count_mode mode, Search search, std::true_type ) {
+        const std::size_t m = std::distance ( pFirst, pLast );
+        if ( m == 0 || m > k_short_byte_pattern || first == last )
+            return count_by_search ( first, last, m, mode, search );
+
+        unsigned char pattern [ k_short_byte_pattern ];
+        std::copy ( pFirst, pLast, pattern );
+        return count_bytes ( reinterpret_cast<const unsigned char *> ( &*first ), std::distance ( first, last ), pattern, m, mode );
+        }
+
+    template <typename Iterator, typename PatternIterator, typename BinaryPredicate, typename Search>
+    std::size_t count_matches ( Iterator first, Iterator last, PatternIterator pFirst, PatternIterator pLast,
+                                const BinaryPredicate &, count_mode mode, Search search ) {
+        typedef typename std::iterator_traits<PatternIterator>::value_type pattern_type;
+        return count_matches ( first, last, pFirst, pLast, mode, search, std::integral_constant<bool,
+                is_contiguous_bytes<Iterator>::value && is_contiguous_bytes<const pattern_type *>::value
+                    && std::is_same<BinaryPredicate, std::equal_to<pattern_type>>::value> ());
+        }
+
+//  Roughly how common a byte is in text, markup and binary data; 0 for the rarest
+    inline std::size_t byte_commonness ( unsigned char c ) {
+        static const char k_by_frequency [] = " etaoinsrhldcumfpgwybvk,.\nETAOINSRHLDCUMFPGWYBVK0123456789"
+                                              "xjqzXJQZ-_/=:;()\"'\t\r<>{}[]!?*&#+@$%|\\^~`";
+        if ( c == 0 || c == 0xff )
+            return sizeof ( k_by_frequency );
+        const void *hit = std::memchr ( k_by_frequency, c, sizeof ( k_by_frequency ) - 1 );
+        return hit == nullptr ? 0 : sizeof ( k_by_frequency ) - 1 - ( static_cast<const char *> ( hit ) - k_by_frequency );
+        }
+
+//  The positions of the two rarest distinct bytes of p [0, m), m >= 1.
+//  If every byte is the same, the second position holds that byte too.
+    inline std::pair<std::size_t, std::size_t> rare_byte_positions ( const unsigned char *p, std::size_t m ) {
+        std::size_t rare1 = 0;
+        for ( std::size_t i = 1; i < m; ++i )
+            if ( byte_commonness ( p [ i ] ) < byte_commonness ( p [ rare1 ] ))
+                rare1 = i;
+        std::size_t rare2 = rare1 == m - 1 ? 0 : m - 1;
+        for ( std::size_t i = 0; i < m; ++i )
+            if ( p [ i ] != p [ rare1 ] && ( p [ rare2 ] == p [ rare1 ] || byte_commonness ( p [ i ] ) < byte_commonness ( p [ rare2 ] )))
+                rare2 = i;
+        return std::make_pair ( rare1, rare2 );
+        }
+
+//  The offset of the first occurrence of p [0, m) in s [0, n), or n if there is none; 1 <= m <= n.
+//  Windows are only compared in full if they hold p's bytes at positions rare1 and rare2.
+    inline std::size_t find_rare_bytes ( const unsigned char *s, std::size_t n, const unsigned char *p, std::size_t m,
+                                         std::size_t rare1, std::size_t rare2 ) {
+        const unsigned char c1 = p [ rare1 ];
+        const unsigned char c2 = p [ rare2 ];
+        std::size_t i = 0;
+#if defined(__SSE2__)
+    //  Test 16 windows at a time on both bytes
+        const __m128i v1 = _mm_set1_epi8 ( static_cast<char> ( c1 ));
+        const __m128i v2 = _mm_set1_epi8 ( static_cast<char> ( c2 ));
+        for ( ; i + 16 + m - 1 <= n; i += 16 ) {
+            const __m128i a = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( s + i + rare1 ));
+            const __m128i b = _mm_loadu_si128 ( reinterpret_cast<const __m128i *> ( s + i + rare2 ));
+            std::uint32_t mask = static_cast<std::uint32_t> ( _mm_movemask_epi8 (
+                        _mm_and_si128 ( _mm_cmpeq_epi8 ( a, v1 ), _mm_cmpeq_epi8 ( b, v2 ))));
+            for ( ; mask != 0; mask &= mask - 1 ) {
+                const std::size_t pos = i + lowest_bit ( mask );
+                if ( std::memcmp ( s + pos, p, m ) == 0 )
+                    return pos;
+                }
+            }
+#endif
+        for ( ; i + m <= n; ++i ) {
+            const void *hit = std::memchr ( s + i + rare1, c1, n - m + 1 - i );
+            if ( hit == nullptr )
+                return n;
+            i = static_cast<const unsigned char *> ( hit ) - s - rare1;
+            if ( s [ i + rare2 ] == c2 && std::memcmp ( s + i, p, m ) == 0 )
+                return i;
+            }
+        return n;
+        }
+
+//  Searchers with a count member use it; for the others, count by searching
+    template <typename Searcher, typename Iterator>
+    auto count_dispatch ( const Searcher &searcher, Iterator first, Iterator last, count_mode mode, int )
+            -> decltype ( searcher.count ( first, last, mode )) {
+        return searcher.count ( first, last, mode );
+        }
+
+    template <typename Searcher, typename Iterator>
+    std::size_t count_dispatch ( const Searcher &searcher, Iterator first, Iterator last, count_mode mode, long ) {
+    //  Without the pattern length, we don't know where a match ends
+        if ( mode != count_mode::overlapping )
+            throw std::invalid_argument ( "tba::count: this searcher can only count overlapping matches" );
+        std::size_t retVal = 0;
+        for ( Iterator it = searcher ( first, last ); it != last; it = searcher ( std::next ( it ), last ))
+            ++retVal;
+        return retVal;
+        }
+    }
+
+/// \fn count ( Iterator first, Iterator last, const Searcher &searcher, count_mode mode )
+/// \brief Returns the number of occurrences of the searcher's pattern in [first, last)
+///
+/// An empty pattern is counted once per corpus element, as a search loop would find it.
+///
+template <typename Iterator, typename Searcher>
+std::size_t count ( Iterator first, Iterator last, const Searcher &searcher, count_mode mode = count_mode::overlapping ) {
+	return detail::count_dispatch ( searcher, first, last, mode, 0 );
+	}
+
 	template <typename Iterator, typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<Iterator>::value_type>>
 	class default_searcher {
 	public:
@@ -31,6 +299,12 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
 		CorpusIterator operator () ( CorpusIterator cFirst, CorpusIterator cLast ) const {
 			return std::search ( cFirst, cLast, first_, last_, pred_ );
 			}
+
+		template <typename CorpusIterator>
+		std::size_t count ( CorpusIterator cFirst, CorpusIterator cLast, count_mode mode = count_mode::overlapping ) const {
+			return detail::count_matches ( cFirst, cLast, first_, last_, pred_, mode,
+				[this] ( CorpusIterator f, CorpusIterator l ) { return std::search ( f, l, first_, last_, pred_ ); });
+			}
 	
 	private:
 		Iterator first_;
@@ -42,25 +316,27 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
 //
 //  Default implementations of the skip tables for B-M and B-M-H
 //
-    template<typename key_type, typename value_type, typename BinaryPredicate, bool /*useArray*/> class skip_table;
+    template<typename key_type, typename value_type, typename Hash, typename BinaryPredicate, bool /*useArray*/> class skip_table;
 
 //  General case for data searching other than bytes; use a map
-    template<typename key_type, typename value_type, typename BinaryPredicate>
-    class skip_table<key_type, value_type, BinaryPredicate, false> {
+    template<typename key_type, typename value_type, typename Hash, typename BinaryPredicate>
+    class skip_table<key_type, value_type, Hash, BinaryPredicate, false> {
     private:
         const value_type k_default_value;
-        std::unordered_map<key_type, value_type, BinaryPredicate> skip_;
+        std::unordered_map<key_type, value_type, Hash, BinaryPredicate> skip_;
         
     public:
         skip_table () = delete;
-        skip_table ( std::size_t patSize, value_type default_value ) 
-            : k_default_value ( default_value ), skip_ ( patSize ) {}
+        skip_table ( std::size_t patSize, value_type default_value, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) 
+            : k_default_value ( default_value ), skip_ ( patSize, hash, pred ) {}
         
-        void insert ( key_type key, value_type val ) {
+        void insert ( const key_type &key, value_type val ) {
             skip_ [ key ] = val;    // Would skip_.insert (val) be better here?
             }
 
-        value_type operator [] ( key_type key ) const {
+        void seal () {}
+
+        value_type operator [] ( const key_type &key ) const {
             auto it = skip_.find ( key );
             return it == skip_.end () ? k_default_value : it->second;
             }
@@ -68,15 +344,16 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
         
     
 //  Special case small numeric values; use an array
-    template<typename key_type, typename value_type, typename BinaryPredicate>
-    class skip_table<key_type, value_type, BinaryPredicate, true> {
+    template<typename key_type, typename value_type, typename Hash, typename BinaryPredicate>
+    class skip_table<key_type, value_type, Hash, BinaryPredicate, true> {
     private:
         typedef typename std::make_unsigned<key_type>::type unsigned_key_type;
         typedef std::array<value_type, 1U << (CHAR_BIT * sizeof(key_type))> skip_map;
         skip_map skip_;
         const value_type k_default_value;
     public:
-        skip_table ( std::size_t /*patSize*/, value_type default_value ) : k_default_value ( default_value ) {
+        skip_table ( std::size_t /*patSize*/, value_type default_value, Hash = Hash (), BinaryPredicate = BinaryPredicate ()) 
+                : k_default_value ( default_value ) {
             std::fill_n ( skip_.begin(), skip_.size(), default_value );
             }
         
@@ -84,29 +361,183 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
             skip_ [ static_cast<unsigned_key_type> ( key ) ] = val;
             }
 
+        void seal () {}
+
         value_type operator [] ( key_type key ) const {
             return skip_ [ static_cast<unsigned_key_type> ( key ) ];
             }
         };
 
-    template<typename Iterator, typename BinaryPredicate>
+namespace detail {
+//  Spreads the bits of a user's hash (which may be the identity) over the whole word
+    inline std::uint64_t mix_hash ( std::uint64_t h ) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+        }
+
+//  Maps a 32-bit value onto [0, n) without a division
+    inline std::size_t reduce32 ( std::uint64_t x, std::size_t n ) {
+        return static_cast<std::size_t> ((( x & 0xffffffffULL ) * n ) >> 32 );
+        }
+    }
+
+//  A minimal perfect hash over the keys of the pattern, for element types that
+//  cannot use an array (tokens, structs). Keys are collected in a map until
+//  seal () is called, which places them in a flat array with exactly one slot
+//  per key: the keys are split into buckets of about four, and each bucket is
+//  given the first seed that sends its keys to free slots (as in CHD).
+//
+//  A lookup hashes the key, reads its bucket's seed and then its slot. Each slot
+//  keeps 32 bits of its key's hash, so a key that is not in the pattern is
+//  almost never compared. If the hash cannot tell two keys apart, the table
+//  keeps using the map.
+    template<typename key_type, typename value_type, typename Hash, typename BinaryPredicate>
+    class perfect_hash_skip_table {
+    public:
+        perfect_hash_skip_table ( std::size_t patSize, value_type default_value, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ())
+            : k_default_value ( default_value ), hash_ ( hash ), pred_ ( pred ), staged_ ( patSize, hash, pred ) {}
+
+    //  Keys may only be inserted before seal () is called
+        void insert ( const key_type &key, value_type val ) {
+            staged_ [ key ] = val;
+            }
+
+        void seal () {
+            const std::size_t n = staged_.size ();
+            if ( n == 0 )
+                return;
+
+            std::vector<const std::pair<const key_type, value_type> *> entries;
+            std::vector<std::uint64_t> hashes;
+            for ( auto it = staged_.begin (); it != staged_.end (); ++it ) {
+                entries.push_back ( &*it );
+                hashes.push_back ( detail::mix_hash ( hash_ ( it->first )));
+                }
+            std::vector<std::uint64_t> sorted ( hashes );
+            std::sort ( sorted.begin (), sorted.end ());
+            if ( std::adjacent_find ( sorted.begin (), sorted.end ()) != sorted.end ())
+                return;     // no seed can separate keys with the same hash
+
+            const std::size_t buckets = n / 4 + 1;
+            std::vector<std::vector<std::size_t>> members ( buckets );
+            for ( std::size_t i = 0; i < n; ++i )
+                members [ detail::reduce32 ( hashes [ i ] >> 32, buckets ) ].push_back ( i );
+            std::vector<std::size_t> order ( buckets );
+            for ( std::size_t b = 0; b < buckets; ++b )
+                order [ b ] = b;
+            std::stable_sort ( order.begin (), order.end (),
+                [&members] ( std::size_t x, std::size_t y ) { return members [ x ].size () > members [ y ].size (); });
+
+        //  The biggest buckets go first, while most of the slots are free
+            std::vector<std::uint32_t> seeds ( buckets, 0 );
+            std::vector<std::size_t> owner ( n, n );    // the entry in each slot, or n
+            std::vector<std::size_t> slots;
+            for ( std::size_t b : order ) {
+                const std::vector<std::size_t> &keys = members [ b ];
+                if ( keys.empty ())
+                    break;
+                std::uint32_t seed = 0;
+                for ( ; seed < k_max_seed; ++seed ) {
+                    slots.clear ();
+                    for ( std::size_t i : keys ) {
+                        const std::size_t slot = slot_of ( hashes [ i ], seed, n );
+                        if ( owner [ slot ] != n || std::find ( slots.begin (), slots.end (), slot ) != slots.end ())
+                            break;
+                        slots.push_back ( slot );
+                        }
+                    if ( slots.size () == keys.size ())
+                        break;
+                    }
+                if ( seed == k_max_seed )
+                    return;
+                seeds [ b ] = seed;
+                for ( std::size_t k = 0; k < keys.size (); ++k )
+                    owner [ slots [ k ]] = keys [ k ];
+                }
+
+            for ( std::size_t slot = 0; slot < n; ++slot ) {
+                const std::size_t i = owner [ slot ];
+                keys_.push_back ( entries [ i ]->first );
+                slots_.push_back ( slot_entry { static_cast<std::uint32_t> ( hashes [ i ] ), entries [ i ]->second });
+                }
+            seeds_.swap ( seeds );
+            staged_type ().swap ( staged_ );
+            }
+
+        value_type operator [] ( const key_type &key ) const {
+            if ( seeds_.empty ()) {     // not sealed, or sealing failed
+                auto it = staged_.find ( key );
+                return it == staged_.end () ? k_default_value : it->second;
+                }
+            const std::uint64_t h = detail::mix_hash ( hash_ ( key ));
+            const std::size_t slot = slot_of ( h, seeds_ [ detail::reduce32 ( h >> 32, seeds_.size ()) ], slots_.size ());
+            const slot_entry &e = slots_ [ slot ];
+            return e.fingerprint == static_cast<std::uint32_t> ( h ) && pred_ ( keys_ [ slot ], key ) ? e.value : k_default_value;
+            }
+
+    private:
+        typedef std::unordered_map<key_type, value_type, Hash, BinaryPredicate> staged_type;
+        struct slot_entry {
+            std::uint32_t fingerprint;  // the low bits of the key's hash
+            value_type value;
+            };
+        static const std::uint32_t k_max_seed = 1U << 20;
+
+        static std::size_t slot_of ( std::uint64_t h, std::uint32_t seed, std::size_t n ) {
+            return detail::reduce32 ((( h ^ ( seed * 0xd6e8feb86659fd93ULL )) * 0x9e3779b97f4a7c15ULL ) >> 32, n );
+            }
+
+        value_type k_default_value;
+        Hash hash_;
+        BinaryPredicate pred_;
+        staged_type staged_;
+        std::vector<std::uint32_t> seeds_;      // one per bucket
+        std::vector<key_type> keys_;            // one per slot
+        std::vector<slot_entry> slots_;
+        };
+
+//  The array can only be used when the predicate is plain equality; 
+//  anything else (case-insensitive, say) has to go through the user's hash.
+    template<typename key_type, typename BinaryPredicate>
+    struct use_array_skip_table : std::integral_constant<bool,
+            std::is_integral<key_type>::value && (sizeof(key_type)==1) &&
+            std::is_same<BinaryPredicate, std::equal_to<key_type>>::value> {};
+
+    template<typename Iterator, typename Hash, typename BinaryPredicate>
     struct BM_traits {
         typedef typename std::iterator_traits<Iterator>::difference_type value_type;
         typedef typename std::iterator_traits<Iterator>::value_type key_type;
-        typedef skip_table<key_type, value_type, BinaryPredicate, 
-                std::is_integral<key_type>::value && (sizeof(key_type)==1)> skip_table_t;
+        typedef skip_table<key_type, value_type, Hash, BinaryPredicate, 
+                use_array_skip_table<key_type, BinaryPredicate>::value> skip_table_t;
+        };
+
+//  Selects the perfect hash skip table, for boyer_moore_searcher<It, Hash, Pred, perfect_hash_BM_traits<It, Hash, Pred>>
+    template<typename Iterator, typename Hash, typename BinaryPredicate>
+    struct perfect_hash_BM_traits {
+        typedef typename std::iterator_traits<Iterator>::difference_type value_type;
+        typedef typename std::iterator_traits<Iterator>::value_type key_type;
+        typedef perfect_hash_skip_table<key_type, value_type, Hash, BinaryPredicate> skip_table_t;
         };
 
 
-    template <typename ForwardIterator, typename Hash, typename BinaryPredicate>
+//  Grants the image writer in searcher_image.hpp access to the compiled tables
+    struct image_access;
+
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate,
+              typename Traits = BM_traits<ForwardIterator, Hash, BinaryPredicate>>
     class boyer_moore_searcher {
+        friend struct image_access;
         typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
         typedef typename std::iterator_traits<ForwardIterator>::value_type      value_type;
     public:
         boyer_moore_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred )
                 : first_ ( first ), last_ ( last ), hash_ ( hash ), pred_ ( pred ),
                   k_pattern_length ( std::distance ( first_, last_ )),
-                  skip_ ( k_pattern_length, hash_, pred_ ),
+                  skip_ ( k_pattern_length, k_pattern_length, hash_, pred_ ),
                   suffix_ ( k_pattern_length + 1 )
             {
             this->build_skip_table   ( first_, last_ );
@@ -140,13 +571,23 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
             return this->do_search   ( corpus_first, corpus_last );
             }
             
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
     private:
         ForwardIterator first_;
         ForwardIterator last_;
         Hash hash_;					//	do I need this?
         BinaryPredicate pred_;		//	I'm pretty sure I need this
         const difference_type k_pattern_length;
-        std::unordered_map<value_type, difference_type, Hash, BinaryPredicate> skip_;
+        typename Traits::skip_table_t skip_;
         std::vector <difference_type> suffix_;
 
         /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last, Pred p )
@@ -174,10 +615,7 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
                     }
                 
             //  Since we didn't match, figure out how far to skip forward
-         	//	k = skip_ [ ];
-	            auto it = skip_.find ( curPos [ j - 1 ] );
-                k = it == skip_.end () ? k_pattern_length : it->second;
-         	
+                k = skip_ [ curPos [ j - 1 ] ];
                 m = j - k - 1;
                 if ( k < j && m > suffix_ [ j ] )
                     curPos += m;
@@ -191,8 +629,8 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
 
         void build_skip_table ( ForwardIterator first, ForwardIterator last ) {
             for ( std::size_t i = 0; first != last; ++first, ++i )
-            	skip_ [ *first ] = i;
-          //    skip_.insert ( *first, i );
+                skip_.insert ( *first, i );
+            skip_.seal ();
             }
         
 
@@ -244,33 +682,49 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
             }
         };
 
-#if 0
-    template <typename patIter, typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<patIter>::value_type>, typename traits = BM_traits<patIter, BinaryPredicate>>
-    class boyer_moore_horspool_searcher {
-        typedef typename std::iterator_traits<patIter>::difference_type difference_type;
+//
+//  Backward factor searchers. Instead of looking up single characters, as
+//  B-M does, these read the window from right to left for as long as what
+//  they have read is still a factor (substring) of the pattern, and then shift
+//  past it. On small alphabets (DNA, binary) this gives far longer shifts than
+//  the bad-character rule.
+//
+
+//  Backward Nondeterministic DAWG Matching, bit-parallel in a 64-bit word.
+//  Patterns longer than 64 elements are filtered on their first 64 elements,
+//  and candidates are then verified against the rest of the pattern.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate>
+    class bndm_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+        typedef typename std::iterator_traits<ForwardIterator>::value_type      value_type;
+        typedef std::uint64_t mask_type;
+        typedef skip_table<value_type, mask_type, Hash, BinaryPredicate,
+                use_array_skip_table<value_type, BinaryPredicate>::value> mask_table;
     public:
-        boyer_moore_horspool_searcher ( patIter first, patIter last, BinaryPredicate pred = BinaryPredicate ()) 
+        bndm_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred )
                 : first_ ( first ), last_ ( last ), pred_ ( pred ),
                   k_pattern_length ( std::distance ( first_, last_ )),
-                  skip_ ( k_pattern_length, k_pattern_length ) {
-                  
-            std::size_t i = 0;
-            if ( first_ != last_ )    // empty pattern?
-                for ( patIter iter = first_; iter != last_-1; ++iter, ++i )
-                    skip_.insert ( *iter, k_pattern_length - 1 - i );
+                  k_window ( std::min<difference_type> ( k_pattern_length, CHAR_BIT * sizeof ( mask_type ))),
+                  masks_ ( k_window, 0, hash, pred )
+            {
+        //  Bit (w - 1 - i) of the mask for c is set if the pattern has c at position i
+            ForwardIterator it = first_;
+            for ( difference_type i = 0; i < k_window; ++i, ++it )
+                masks_.insert ( *it, masks_ [ *it ] | ( mask_type ( 1 ) << ( k_window - 1 - i )));
             }
 
-        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last, Pred p )
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
         /// \brief Searches the corpus for the pattern that was passed into the constructor
         /// 
         /// \param corpus_first The start of the data to search (Random Access Iterator)
         /// \param corpus_last  One past the end of the data to search
         ///
-        template <typename corpusIter>
-        corpusIter operator () ( corpusIter corpus_first, corpusIter corpus_last ) const {
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
             static_assert ( std::is_same<
-                    typename std::decay<typename std::iterator_traits<patIter>   ::value_type>::type, 
-                    typename std::decay<typename std::iterator_traits<corpusIter>::value_type>::type
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>     ::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
                     	>::value,
                     "Corpus and Pattern iterators must point to the same type" );
 
@@ -279,64 +733,947 @@ Iterator search ( Iterator first, Iterator last, const Searcher &searcher ) {
 
             const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
         //  If the pattern is larger than the corpus, we can't find it!
-            if ( k_corpus_length < k_pattern_length )
+            if ( k_corpus_length < k_pattern_length ) 
                 return corpus_last;
-    
-        //  Do the search 
+
             return this->do_search ( corpus_first, corpus_last );
             }
 
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
     private:
-        patIter first_, last_;
+        ForwardIterator first_;
+        ForwardIterator last_;
         BinaryPredicate pred_;
         const difference_type k_pattern_length;
-        typename traits::skip_table_t skip_;
+        const difference_type k_window;
+        mask_table masks_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
+            const mask_type k_high = mask_type ( 1 ) << ( k_window - 1 );
+            const mask_type k_all  = k_high | ( k_high - 1 );
+            corpusIter curPos = corpus_first;
+            const corpusIter lastPos = corpus_last - k_pattern_length;
+
+            while ( curPos <= lastPos ) {
+                difference_type j = k_window;
+                difference_type shift = k_window;
+                mask_type d = k_all;
+                while ( d != 0 ) {
+                    d &= masks_ [ curPos [ j - 1 ]];
+                    --j;
+                    if ( d & k_high ) {
+                    //  What we've read is a prefix of the pattern
+                        if ( j > 0 )
+                            shift = j;
+                        else {
+                            if ( this->verify_tail ( curPos ))
+                                return curPos;
+                            break;
+                            }
+                        }
+                    d <<= 1;
+                    }
+                curPos += shift;
+                }
+
+            return corpus_last;     // We didn't find anything
+            }
+
+    //  The first k_window elements are known to match; check the rest
+        template <typename corpusIter>
+        bool verify_tail ( corpusIter curPos ) const {
+            ForwardIterator it = first_;
+            std::advance ( it, k_window );
+            for ( curPos += k_window; it != last_; ++it, ++curPos )
+                if ( !pred_ ( *it, *curPos ))
+                    return false;
+            return true;
+            }
+        };
+
+
+//  Backward Oracle Matching. The factor oracle of the reversed pattern
+//  recognizes (at least) every factor of the pattern, and has at most 2m
+//  transitions, which are stored as a flat list per state. The oracle may
+//  accept a window that is not an occurrence, so full windows are verified.
+    template <typename ForwardIterator, typename BinaryPredicate>
+    class backward_oracle_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+        typedef typename std::iterator_traits<ForwardIterator>::value_type      value_type;
+        typedef std::pair<value_type, difference_type> transition;
+    public:
+        backward_oracle_searcher ( ForwardIterator first, ForwardIterator last, BinaryPredicate pred )
+                : first_ ( first ), last_ ( last ), pred_ ( pred ),
+                  k_pattern_length ( std::distance ( first_, last_ ))
+            {
+            this->build_oracle ( first_, last_ );
+            }
 
-        /// \fn do_search ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
         /// \brief Searches the corpus for the pattern that was passed into the constructor
         /// 
         /// \param corpus_first The start of the data to search (Random Access Iterator)
         /// \param corpus_last  One past the end of the data to search
         ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>     ::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last  ) return corpus_last;  // if nothing to search, we didn't find it!
+            if (       first_ ==        last_ ) return corpus_first; // empty pattern matches at start
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( k_corpus_length < k_pattern_length ) 
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
+    private:
+        ForwardIterator first_;
+        ForwardIterator last_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+    //  The transitions out of state s are edges_ [ offsets_ [s], offsets_ [s+1] )
+        std::vector<std::size_t> offsets_;
+        std::vector<transition> edges_;
+
+        difference_type next_state ( difference_type state, const value_type &c ) const {
+            for ( std::size_t i = offsets_ [ state ]; i < offsets_ [ state + 1 ]; ++i )
+                if ( pred_ ( edges_ [ i ].first, c ))
+                    return edges_ [ i ].second;
+            return -1;
+            }
+
         template <typename corpusIter>
         corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
             corpusIter curPos = corpus_first;
             const corpusIter lastPos = corpus_last - k_pattern_length;
+
             while ( curPos <= lastPos ) {
-            //  Do we match right where we are?
-                std::size_t j = k_pattern_length - 1;
-                while ( pred_ ( first_ [j], curPos [j] )) {
-                //  We matched - we're done!
-                    if ( j == 0 )
-                        return curPos;
-                    j--;
+                difference_type state = 0;
+                difference_type j = k_pattern_length;
+                while ( j > 0 && state >= 0 ) {
+                    state = this->next_state ( state, curPos [ j - 1 ] );
+                    --j;
                     }
-        
-                curPos += skip_ [ curPos [ k_pattern_length - 1 ]];
+
+                if ( state < 0 )
+                    curPos += j + 1;    // curPos [j] was not in any factor
+                else if ( std::equal ( first_, last_, curPos, pred_ ))
+                    return curPos;
+                else
+                    ++curPos;
                 }
-            
-            return corpus_last;
+
+            return corpus_last;     // We didn't find anything
+            }
+
+    //  Allauzen, Crochemore & Raffinot's online construction, over the pattern reversed
+        void build_oracle ( ForwardIterator first, ForwardIterator last ) {
+            const std::size_t m = k_pattern_length;
+            std::vector<value_type> reversed ( first, last );
+            std::reverse ( reversed.begin (), reversed.end ());
+
+            std::vector<std::vector<transition>> delta ( m + 1 );
+            std::vector<difference_type> supply ( m + 1 );
+            supply [ 0 ] = -1;
+            for ( std::size_t i = 1; i <= m; ++i ) {
+                const value_type &c = reversed [ i - 1 ];
+                delta [ i - 1 ].push_back ( transition ( c, i ));
+                difference_type k = supply [ i - 1 ];
+                difference_type target = -1;
+                while ( k >= 0 ) {
+                    target = -1;
+                    for ( std::size_t e = 0; e < delta [ k ].size (); ++e )
+                        if ( pred_ ( delta [ k ] [ e ].first, c ))
+                            target = delta [ k ] [ e ].second;
+                    if ( target >= 0 )
+                        break;
+                    delta [ k ].push_back ( transition ( c, i ));
+                    k = supply [ k ];
+                    }
+                supply [ i ] = k < 0 ? 0 : target;
+                }
+
+        //  Flatten, so that a lookup touches one contiguous run of edges
+            offsets_.reserve ( m + 2 );
+            for ( std::size_t s = 0; s <= m; ++s ) {
+                offsets_.push_back ( edges_.size ());
+                edges_.insert ( edges_.end (), delta [ s ].begin (), delta [ s ].end ());
+                }
+            offsets_.push_back ( edges_.size ());
             }
         };
-#endif
 
-template <typename Iterator, typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<Iterator>::value_type>>
-default_searcher<Iterator, BinaryPredicate> make_searcher ( Iterator first, Iterator last, BinaryPredicate pred = BinaryPredicate ()) {
-	return default_searcher<Iterator, BinaryPredicate> ( first, last, pred );
-	}
 
-template <typename ForwardIterator, 
-          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
-          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
-boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate> make_boyer_moore_searcher ( 
-	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
-	return boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate> ( first, last, hash, pred );
-	}
+namespace detail {
+//  Polynomial fingerprints over the user's element hash, modulo 2^64.
+//  The fingerprint of a window is h(w0)*B^(m-1) + ... + h(w(m-1)).
+    struct rolling_hash {
+        static const std::uint64_t k_base = 0x100000001b3ULL;
 
-#if 0
-template <typename Iterator, typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<Iterator>::value_type>, typename traits=BM_traits<Iterator, BinaryPredicate>>
-boyer_moore_horspool_searcher<Iterator, BinaryPredicate, traits> make_boyer_moore_horspool_searcher ( Iterator first, Iterator last, BinaryPredicate pred = BinaryPredicate ()) {
-	return boyer_moore_horspool_searcher<Iterator, BinaryPredicate, traits> ( first, last, pred );
-	}
-#endif
-}
+    //  B^(m-1); the weight of the element leaving the window
+        static std::uint64_t leading_power ( std::size_t m ) {
+            std::uint64_t retVal = 1;
+            for ( std::size_t i = 1; i < m; ++i )
+                retVal *= k_base;
+            return retVal;
+            }
+
+        template <typename Iterator, typename Hash>
+        static std::uint64_t fingerprint ( Iterator first, Iterator last, const Hash &hash ) {
+            std::uint64_t retVal = 0;
+            for ( ; first != last; ++first )
+                retVal = retVal * k_base + static_cast<std::uint64_t> ( hash ( *first ));
+            return retVal;
+            }
+
+    //  Calls f ( window_start, fingerprint ) for every window of length m, left to right,
+    //  until f returns true. Each corpus element is hashed exactly once; the hashes of
+    //  the elements still in the window are kept in a ring, so that they can be rolled out.
+        template <typename CorpusIterator, typename Hash, typename F>
+        static CorpusIterator roll ( CorpusIterator corpus_first, CorpusIterator corpus_last,
+                                     std::size_t m, const Hash &hash, F f ) {
+            const std::uint64_t k_high = leading_power ( m );
+            std::vector<std::uint64_t> ring ( m );
+            std::uint64_t fp = 0;
+            CorpusIterator tail = corpus_first;
+            CorpusIterator head = corpus_first;
+            for ( std::size_t i = 0; i < m; ++i, ++head ) {
+                ring [ i ] = static_cast<std::uint64_t> ( hash ( *head ));
+                fp = fp * k_base + ring [ i ];
+                }
+
+            std::size_t slot = 0;
+            for ( ;; ) {
+                if ( f ( tail, fp ))
+                    return tail;
+                if ( head == corpus_last )
+                    return corpus_last;
+                const std::uint64_t h = static_cast<std::uint64_t> ( hash ( *head ));
+                fp = ( fp - ring [ slot ] * k_high ) * k_base + h;
+                ring [ slot ] = h;
+                if ( ++slot == m )
+                    slot = 0;
+                ++head;
+                ++tail;
+                }
+            }
+        };
+    }
+
+
+//  Rabin-Karp. Every element is hashed once, no matter how the pattern is
+//  built, which suits element types that are expensive to hash or compare
+//  (tokens, structs, wide IDs), where the Boyer-Moore skip table lookups cost
+//  more than they save. The Hash must agree with the BinaryPredicate: elements
+//  that compare equal must hash equally. Windows with the pattern's fingerprint
+//  are verified with the predicate.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate>
+    class rabin_karp_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+    public:
+        rabin_karp_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred )
+                : first_ ( first ), last_ ( last ), hash_ ( hash ), pred_ ( pred ),
+                  k_pattern_length ( std::distance ( first_, last_ )),
+                  target_ ( detail::rolling_hash::fingerprint ( first_, last_, hash_ )) {}
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        /// 
+        /// \param corpus_first The start of the data to search (Forward Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename CorpusIterator>
+        CorpusIterator 
+        operator () ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<CorpusIterator> ::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last  ) return corpus_last;  // if nothing to search, we didn't find it!
+            if (       first_ ==        last_ ) return corpus_first; // empty pattern matches at start
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( k_corpus_length < k_pattern_length ) 
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename CorpusIterator>
+        std::size_t count ( CorpusIterator corpus_first, CorpusIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( CorpusIterator f, CorpusIterator l ) { return this->do_search ( f, l ); });
+            }
+
+    private:
+        ForwardIterator first_;
+        ForwardIterator last_;
+        Hash hash_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+        const std::uint64_t target_;
+
+        template <typename CorpusIterator>
+        CorpusIterator do_search ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            return detail::rolling_hash::roll ( corpus_first, corpus_last, k_pattern_length, hash_,
+                [this] ( CorpusIterator window, std::uint64_t fp ) {
+                    return fp == target_ && std::equal ( first_, last_, window, pred_ );
+                    });
+            }
+        };
+
+
+//  Rabin-Karp for a set of patterns, all of the same length. The fingerprints
+//  of the patterns are kept in a hash table, behind a small bit filter that
+//  rejects most windows without a table lookup. find () also reports which
+//  pattern matched; patterns that are equal to an earlier one are never reported.
+//  Like the other searchers, this refers to the caller's patterns rather than
+//  copying them, so they must outlive the searcher.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate>
+    class rabin_karp_set_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+        static const std::size_t k_filter_bits = 4096;
+    public:
+        /// \param patterns_first, patterns_last  A range of patterns; each must have begin () and end ()
+        ///
+        template <typename PatternSetIterator>
+        rabin_karp_set_searcher ( PatternSetIterator patterns_first, PatternSetIterator patterns_last,
+                                  Hash hash, BinaryPredicate pred )
+                : hash_ ( hash ), pred_ ( pred ), k_pattern_length ( 0 ), filter_ () {
+            for ( ; patterns_first != patterns_last; ++patterns_first ) {
+                const ForwardIterator first = std::begin ( *patterns_first );
+                const ForwardIterator last  = std::end   ( *patterns_first );
+                const difference_type len = std::distance ( first, last );
+                if ( patterns_.empty ())
+                    k_pattern_length = len;
+                else if ( len != k_pattern_length )
+                    throw std::invalid_argument ( "rabin_karp_set_searcher: patterns must all be the same length" );
+
+                const std::uint64_t fp = detail::rolling_hash::fingerprint ( first, last, hash_ );
+                const bool duplicate = this->lookup ( first, fp ) != patterns_.size ();
+                if ( !duplicate )
+                    fingerprints_.insert ( std::make_pair ( fp, patterns_.size ()));
+                patterns_.push_back ( std::make_pair ( first, last ));
+                filter_ [ filter_slot ( fp ) / 64 ] |= std::uint64_t ( 1 ) << ( filter_slot ( fp ) % 64 );
+                }
+            }
+
+        /// \brief The number of patterns
+        std::size_t size () const { return patterns_.size (); }
+
+        /// \fn find ( CorpusIterator corpus_first, CorpusIterator corpus_last )
+        /// \brief Finds the first place where any of the patterns occurs
+        ///
+        /// \return The position of the match and the index of the pattern that matched,
+        ///         or ( corpus_last, size ()) if there is none
+        ///
+        template <typename CorpusIterator>
+        std::pair<CorpusIterator, std::size_t>
+        find ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<CorpusIterator> ::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            const std::pair<CorpusIterator, std::size_t> notFound ( corpus_last, patterns_.size ());
+            if ( patterns_.empty ())            return notFound;
+            if ( corpus_first == corpus_last  ) return notFound;    // if nothing to search, we didn't find it!
+            if ( k_pattern_length == 0 )        return std::make_pair ( corpus_first, std::size_t ( 0 ));
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the patterns are larger than the corpus, we can't find them!
+            if ( k_corpus_length < k_pattern_length ) 
+                return notFound;
+
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        template <typename CorpusIterator>
+        CorpusIterator operator () ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            return this->find ( corpus_first, corpus_last ).first;
+            }
+
+        /// \fn count ( CorpusIterator corpus_first, CorpusIterator corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of all the patterns in the corpus
+        ///
+        template <typename CorpusIterator>
+        std::size_t count ( CorpusIterator corpus_first, CorpusIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            if ( patterns_.empty ())
+                return 0;
+            return detail::count_by_search ( corpus_first, corpus_last, k_pattern_length, mode,
+                [this] ( CorpusIterator f, CorpusIterator l ) { return this->do_search ( f, l ).first; });
+            }
+
+    private:
+        Hash hash_;
+        BinaryPredicate pred_;
+        difference_type k_pattern_length;
+        std::vector<std::pair<ForwardIterator, ForwardIterator>> patterns_;
+        std::unordered_multimap<std::uint64_t, std::size_t> fingerprints_;
+        std::array<std::uint64_t, k_filter_bits / 64> filter_;
+
+        static std::size_t filter_slot ( std::uint64_t fp ) {
+            return static_cast<std::size_t> ( fp >> 52 );   // the high bits mix in every element
+            }
+
+        template <typename CorpusIterator>
+        std::pair<CorpusIterator, std::size_t> do_search ( CorpusIterator corpus_first, CorpusIterator corpus_last ) const {
+            std::size_t found = patterns_.size ();
+            const CorpusIterator it = detail::rolling_hash::roll ( corpus_first, corpus_last, k_pattern_length, hash_,
+                [this, &found] ( CorpusIterator window, std::uint64_t fp ) {
+                    const std::size_t slot = filter_slot ( fp );
+                    if (( filter_ [ slot / 64 ] & ( std::uint64_t ( 1 ) << ( slot % 64 ))) == 0 )
+                        return false;
+                    found = this->lookup ( window, fp );
+                    return found != patterns_.size ();
+                    });
+            return std::make_pair ( found == patterns_.size () ? corpus_last : it, found );
+            }
+
+    //  The index of the (first) pattern with this fingerprint that matches the window,
+    //  or the number of patterns if there is none
+        template <typename Iterator>
+        std::size_t lookup ( Iterator window, std::uint64_t fp ) const {
+            const auto range = fingerprints_.equal_range ( fp );
+            for ( auto it = range.first; it != range.second; ++it ) {
+                const std::pair<ForwardIterator, ForwardIterator> &p = patterns_ [ it->second ];
+                if ( std::equal ( p.first, p.second, window, pred_ ))
+                    return it->second;
+                }
+            return patterns_.size ();
+            }
+        };
+
+//
+//  The Horspool family: bad character shifts only, with no good suffix table.
+//  The shift tables use the traits' skip_table, which is an array for bytes.
+//
+
+//  Boyer-Moore-Horspool: compares the window right to left, and shifts by the
+//  distance from the window's last element to its last occurrence in the
+//  rest of the pattern.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate,
+              typename Traits = BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+    class boyer_moore_horspool_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+    public:
+        boyer_moore_horspool_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred ) 
+                : first_ ( first ), last_ ( last ), pred_ ( pred ),
+                  k_pattern_length ( std::distance ( first_, last_ )),
+                  skip_ ( k_pattern_length, k_pattern_length, hash, pred ) {
+            difference_type i = 0;
+            for ( ForwardIterator iter = first_; i + 1 < k_pattern_length; ++iter, ++i )
+                skip_.insert ( *iter, k_pattern_length - 1 - i );
+            skip_.seal ();
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        /// 
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>     ::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last  ) return corpus_last;  // if nothing to search, we didn't find it!
+            if (       first_ ==        last_ ) return corpus_first; // empty pattern matches at start
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( k_corpus_length < k_pattern_length )
+                return corpus_last;
+
+        //  Do the search 
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
+    private:
+        ForwardIterator first_;
+        ForwardIterator last_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+        typename Traits::skip_table_t skip_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
+            corpusIter curPos = corpus_first;
+            const corpusIter lastPos = corpus_last - k_pattern_length;
+            while ( curPos <= lastPos ) {
+            //  Do we match right where we are?
+                difference_type j = k_pattern_length - 1;
+                while ( pred_ ( first_ [j], curPos [j] )) {
+                //  We matched - we're done!
+                    if ( j == 0 )
+                        return curPos;
+                    j--;
+                    }
+        
+                curPos += skip_ [ curPos [ k_pattern_length - 1 ]];
+                }
+            
+            return corpus_last;
+            }
+        };
+
+//  Sunday's Quick Search: compares the window left to right, and then shifts
+//  on the element just past the window, which is always part of the next
+//  window. The shifts are one longer than Horspool's, at the cost of reading
+//  one element more.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate,
+              typename Traits = BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+    class sunday_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+    public:
+        sunday_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred ) 
+                : first_ ( first ), last_ ( last ), pred_ ( pred ),
+                  k_pattern_length ( std::distance ( first_, last_ )),
+                  skip_ ( k_pattern_length, k_pattern_length + 1, hash, pred ) {
+            difference_type i = 0;
+            for ( ForwardIterator iter = first_; iter != last_; ++iter, ++i )
+                skip_.insert ( *iter, k_pattern_length - i );
+            skip_.seal ();
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        /// 
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>     ::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last  ) return corpus_last;  // if nothing to search, we didn't find it!
+            if (       first_ ==        last_ ) return corpus_first; // empty pattern matches at start
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( k_corpus_length < k_pattern_length )
+                return corpus_last;
+
+        //  Do the search 
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
+    private:
+        ForwardIterator first_;
+        ForwardIterator last_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+        typename Traits::skip_table_t skip_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
+            corpusIter curPos = corpus_first;
+            const corpusIter lastPos = corpus_last - k_pattern_length;
+            while ( true ) {
+                difference_type j = 0;
+                while ( pred_ ( first_ [j], curPos [j] ))
+                    if ( ++j == k_pattern_length )
+                        return curPos;
+
+            //  There is no element past the last window
+                if ( curPos == lastPos )
+                    return corpus_last;
+                const difference_type shift = skip_ [ curPos [ k_pattern_length ]];
+                if ( lastPos - curPos < shift )
+                    return corpus_last;
+                curPos += shift;
+                }
+            }
+        };
+
+//  Raita: Horspool's shifts, but each window is tested on its last, first and
+//  middle elements before the rest is compared. On text, windows that share
+//  the last element with the pattern seldom share the other two.
+    template <typename ForwardIterator, typename Hash, typename BinaryPredicate,
+              typename Traits = BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+    class raita_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::difference_type difference_type;
+    public:
+        raita_searcher ( ForwardIterator first, ForwardIterator last, Hash hash, BinaryPredicate pred ) 
+                : first_ ( first ), last_ ( last ), pred_ ( pred ),
+                  k_pattern_length ( std::distance ( first_, last_ )),
+                  skip_ ( k_pattern_length, k_pattern_length, hash, pred ) {
+            difference_type i = 0;
+            for ( ForwardIterator iter = first_; i + 1 < k_pattern_length; ++iter, ++i )
+                skip_.insert ( *iter, k_pattern_length - 1 - i );
+            skip_.seal ();
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        /// 
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<typename std::iterator_traits<ForwardIterator>     ::value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last  ) return corpus_last;  // if nothing to search, we didn't find it!
+            if (       first_ ==        last_ ) return corpus_first; // empty pattern matches at start
+
+            const difference_type k_corpus_length  = std::distance ( corpus_first, corpus_last );
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( k_corpus_length < k_pattern_length )
+                return corpus_last;
+
+        //  Do the search 
+            return this->do_search ( corpus_first, corpus_last );
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, first_, last_, pred_, mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l ); });
+            }
+
+    private:
+        ForwardIterator first_;
+        ForwardIterator last_;
+        BinaryPredicate pred_;
+        const difference_type k_pattern_length;
+        typename Traits::skip_table_t skip_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last ) const {
+            const difference_type k_last   = k_pattern_length - 1;
+            const difference_type k_middle = k_pattern_length / 2;
+            corpusIter curPos = corpus_first;
+            const corpusIter lastPos = corpus_last - k_pattern_length;
+            while ( curPos <= lastPos ) {
+                if ( pred_ ( first_ [ k_last ], curPos [ k_last ] ) && pred_ ( first_ [ 0 ], curPos [ 0 ] )
+                        && pred_ ( first_ [ k_middle ], curPos [ k_middle ] )) {
+                    difference_type j = 1;
+                    while ( j < k_last && pred_ ( first_ [j], curPos [j] ))
+                        ++j;
+                    if ( j >= k_last )
+                        return curPos;
+                    }
+                curPos += skip_ [ curPos [ k_last ]];
+                }
+            return corpus_last;
+            }
+        };
+
+//
+//  A filter for short byte patterns, rather than a shifting algorithm.
+//  Every window is a candidate, but windows are tested 16 at a time (with
+//  SSE2, or memchr without it) on the pattern's two rarest bytes, judged by
+//  how common each byte is in text; only those that hold both are compared
+//  in full. It keeps its own copy of the pattern.
+//
+    template <typename ForwardIterator>
+    class rare_byte_searcher {
+        typedef typename std::iterator_traits<ForwardIterator>::value_type value_type;
+        static_assert ( std::is_integral<value_type>::value && sizeof ( value_type ) == 1,
+                "rare_byte_searcher only searches for byte patterns" );
+    public:
+        rare_byte_searcher ( ForwardIterator first, ForwardIterator last )
+                : pattern_ ( first, last ), rare1_ ( 0 ), rare2_ ( 0 ) {
+            if ( !pattern_.empty ()) {
+                const std::pair<std::size_t, std::size_t> rare = detail::rare_byte_positions ( pattern_.data (), pattern_.size ());
+                rare1_ = rare.first;
+                rare2_ = rare.second;
+                }
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        /// 
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator 
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( std::is_same<
+                    typename std::decay<value_type>::type, 
+                    typename std::decay<typename std::iterator_traits<RandomAccessIterator>::value_type>::type
+                    	>::value,
+                    "Corpus and Pattern iterators must point to the same type" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( pattern_.empty ())            return corpus_first; // empty pattern matches at start
+
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( static_cast<std::size_t> ( std::distance ( corpus_first, corpus_last )) < pattern_.size ())
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last,
+                std::integral_constant<bool, detail::is_contiguous_bytes<RandomAccessIterator>::value> ());
+            }
+
+        /// \fn count ( corpusIter corpus_first, corpusIter corpus_last, count_mode mode )
+        /// \brief Counts the occurrences of the pattern in the corpus
+        ///
+        template <typename RandomAccessIterator>
+        std::size_t count ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last, count_mode mode = count_mode::overlapping ) const {
+            return detail::count_matches ( corpus_first, corpus_last, pattern_.begin (), pattern_.end (), std::equal_to<unsigned char> (), mode,
+                [this] ( RandomAccessIterator f, RandomAccessIterator l ) { return this->do_search ( f, l,
+                    std::integral_constant<bool, detail::is_contiguous_bytes<RandomAccessIterator>::value> ()); });
+            }
+
+    private:
+        std::vector<unsigned char> pattern_;
+        std::size_t rare1_;
+        std::size_t rare2_;
+
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last, std::true_type ) const {
+            const std::size_t n = std::distance ( corpus_first, corpus_last );
+            const std::size_t pos = detail::find_rare_bytes ( reinterpret_cast<const unsigned char *> ( &*corpus_first ), n,
+                                                              pattern_.data (), pattern_.size (), rare1_, rare2_ );
+            return pos == n ? corpus_last : corpus_first + pos;
+            }
+
+    //  The same test, a window at a time, for corpora that can't be read directly
+        template <typename corpusIter>
+        corpusIter do_search ( corpusIter corpus_first, corpusIter corpus_last, std::false_type ) const {
+            const std::size_t m = pattern_.size ();
+            const corpusIter lastPos = corpus_last - m;
+            for ( corpusIter curPos = corpus_first; curPos <= lastPos; ++curPos )
+                if ( static_cast<unsigned char> ( curPos [ rare1_ ] ) == pattern_ [ rare1_ ]
+                        && static_cast<unsigned char> ( curPos [ rare2_ ] ) == pattern_ [ rare2_ ] ) {
+                    std::size_t j = 0;
+                    while ( j < m && static_cast<unsigned char> ( curPos [ j ] ) == pattern_ [ j ] )
+                        ++j;
+                    if ( j == m )
+                        return curPos;
+                    }
+            return corpus_last;
+            }
+        };
+
+namespace detail {
+//  Hands out storage that starts on a cache line, so that an owned pattern
+//  never shares its first line with unrelated data.
+    template <typename T, std::size_t Align = 64>
+    struct aligned_allocator {
+        typedef T value_type;
+        template <typename U> struct rebind { typedef aligned_allocator<U, Align> other; };
+
+        aligned_allocator () {}
+        template <typename U> aligned_allocator ( const aligned_allocator<U, Align> & ) {}
+
+        T *allocate ( std::size_t n ) {
+        //  Over-allocate, and stash the original pointer just before the aligned block
+            void *raw = ::operator new ( n * sizeof ( T ) + Align + sizeof ( void * ));
+            std::uintptr_t p = reinterpret_cast<std::uintptr_t> ( raw ) + sizeof ( void * );
+            p = ( p + Align - 1 ) & ~std::uintptr_t ( Align - 1 );
+            reinterpret_cast<void **> ( p ) [ -1 ] = raw;
+            return reinterpret_cast<T *> ( p );
+            }
+
+        void deallocate ( T *p, std::size_t ) {
+            ::operator delete ( reinterpret_cast<void **> ( p ) [ -1 ] );
+            }
+
+        template <typename U> bool operator == ( const aligned_allocator<U, Align> & ) const { return true; }
+        template <typename U> bool operator != ( const aligned_allocator<U, Align> & ) const { return false; }
+        };
+    }
+
+
+//  Wraps a searcher so that it owns a contiguous copy of its pattern.
+//  The copy is made once, at construction, and is shared (read-only) by all
+//  copies of the searcher, so the searcher can be stored and cached freely
+//  without keeping the caller's pattern alive.
+    template <typename ValueType, typename Searcher>
+    class owning_searcher {
+    public:
+        typedef std::vector<ValueType, detail::aligned_allocator<ValueType>> pattern_type;
+
+        template <typename ForwardIterator, typename... Args>
+        owning_searcher ( ForwardIterator first, ForwardIterator last, Args &&... args )
+            : pattern_ ( std::make_shared<pattern_type> ( first, last )),
+              searcher_ ( pattern_->data (), pattern_->data () + pattern_->size (), std::forward<Args> ( args )... ) {}
+
+        template <typename CorpusIterator>
+        CorpusIterator operator () ( CorpusIterator cFirst, CorpusIterator cLast ) const {
+            return searcher_ ( cFirst, cLast );
+            }
+
+        template <typename CorpusIterator>
+        std::size_t count ( CorpusIterator cFirst, CorpusIterator cLast, count_mode mode = count_mode::overlapping ) const {
+            return tba::count ( cFirst, cLast, searcher_, mode );
+            }
+
+        const Searcher &searcher () const { return searcher_; }
+
+    private:
+        std::shared_ptr<const pattern_type> pattern_;   // must be initialized before searcher_
+        Searcher searcher_;
+        };
+
+template <typename Iterator, typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<Iterator>::value_type>>
+default_searcher<Iterator, BinaryPredicate> make_searcher ( Iterator first, Iterator last, BinaryPredicate pred = BinaryPredicate ()) {
+	return default_searcher<Iterator, BinaryPredicate> ( first, last, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename Traits =          BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> make_boyer_moore_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return boyer_moore_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> ( first, last, hash, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+bndm_searcher<ForwardIterator, Hash, BinaryPredicate> make_bndm_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return bndm_searcher<ForwardIterator, Hash, BinaryPredicate> ( first, last, hash, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+backward_oracle_searcher<ForwardIterator, BinaryPredicate> make_backward_oracle_searcher ( 
+	ForwardIterator first, ForwardIterator last, BinaryPredicate pred = BinaryPredicate ()) {
+	return backward_oracle_searcher<ForwardIterator, BinaryPredicate> ( first, last, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+rabin_karp_searcher<ForwardIterator, Hash, BinaryPredicate> make_rabin_karp_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return rabin_karp_searcher<ForwardIterator, Hash, BinaryPredicate> ( first, last, hash, pred );
+	}
+
+template <typename PatternSetIterator, 
+          typename ForwardIterator = decltype ( std::begin ( *std::declval<PatternSetIterator> ())),
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>>
+rabin_karp_set_searcher<ForwardIterator, Hash, BinaryPredicate> make_rabin_karp_set_searcher ( 
+	PatternSetIterator patterns_first, PatternSetIterator patterns_last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return rabin_karp_set_searcher<ForwardIterator, Hash, BinaryPredicate> ( patterns_first, patterns_last, hash, pred );
+	}
+
+template <typename ForwardIterator>
+rare_byte_searcher<ForwardIterator> make_rare_byte_searcher ( ForwardIterator first, ForwardIterator last ) {
+	return rare_byte_searcher<ForwardIterator> ( first, last );
+	}
+
+template <typename ForwardIterator, 
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename ValueType =       typename std::iterator_traits<ForwardIterator>::value_type>
+owning_searcher<ValueType, default_searcher<const ValueType *, BinaryPredicate>> make_owning_searcher ( 
+	ForwardIterator first, ForwardIterator last, BinaryPredicate pred = BinaryPredicate ()) {
+	return owning_searcher<ValueType, default_searcher<const ValueType *, BinaryPredicate>> ( first, last, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename ValueType =       typename std::iterator_traits<ForwardIterator>::value_type>
+owning_searcher<ValueType, boyer_moore_searcher<const ValueType *, Hash, BinaryPredicate>> make_owning_boyer_moore_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return owning_searcher<ValueType, boyer_moore_searcher<const ValueType *, Hash, BinaryPredicate>> ( first, last, hash, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename Traits =          BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+boyer_moore_horspool_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> make_boyer_moore_horspool_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return boyer_moore_horspool_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> ( first, last, hash, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename Traits =          BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+sunday_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> make_sunday_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return sunday_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> ( first, last, hash, pred );
+	}
+
+template <typename ForwardIterator, 
+          typename Hash =            typename std::hash    <typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename BinaryPredicate = typename std::equal_to<typename std::iterator_traits<ForwardIterator>::value_type>,
+          typename Traits =          BM_traits<ForwardIterator, Hash, BinaryPredicate>>
+raita_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> make_raita_searcher ( 
+	ForwardIterator first, ForwardIterator last, Hash hash = Hash (), BinaryPredicate pred = BinaryPredicate ()) {
+	return raita_searcher<ForwardIterator, Hash, BinaryPredicate, Traits> ( first, last, hash, pred );
+	}
+}
+
+#endif // TBA_SEARCHING_HPP
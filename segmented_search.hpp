@@ -0,0 +1,131 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Searching a corpus that is split across several buffers, without copying it together.
+//
+//  segmented_search ( first, last, searcher, pattern_length ) searches a range
+//  of segments, each of which is contiguous: a std::pair<const T *, size_t>,
+//  anything with data () and size () (std::vector, std::string, std::array,
+//  std::span), or (on POSIX) a struct iovec. The searcher is run directly on
+//  each segment. Only the windows that straddle the end of a segment are
+//  copied, into a scratch buffer of at most 2 * ( pattern_length - 1 )
+//  elements, and searched there.
+//
+//  Matches are reported as segment_position { segment, offset }.
+//
+
+#ifndef TBA_SEGMENTED_SEARCH_HPP
+#define TBA_SEGMENTED_SEARCH_HPP
+
+#include "searching.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
+namespace tba {
+
+    struct segment_position {
+        std::size_t segment;
+        std::size_t offset;
+        };
+
+    inline bool operator == ( const segment_position &lhs, const segment_position &rhs ) {
+        return lhs.segment == rhs.segment && lhs.offset == rhs.offset;
+        }
+
+    inline bool operator != ( const segment_position &lhs, const segment_position &rhs ) {
+        return !( lhs == rhs );
+        }
+
+namespace detail {
+//  The contiguous storage of one segment
+    template <typename T, typename Size>
+    const T *segment_data ( const std::pair<T *, Size> &s ) { return s.first; }
+
+    template <typename T, typename Size>
+    std::size_t segment_size ( const std::pair<T *, Size> &s ) { return static_cast<std::size_t> ( s.second ); }
+
+    template <typename Container>
+    auto segment_data ( const Container &c ) -> decltype ( c.data ()) { return c.data (); }
+
+    template <typename Container>
+    auto segment_size ( const Container &c ) -> decltype ( static_cast<std::size_t> ( c.size ())) { return c.size (); }
+
+#if defined(__unix__) || defined(__APPLE__)
+    inline const char *segment_data ( const ::iovec &v ) { return static_cast<const char *> ( v.iov_base ); }
+    inline std::size_t segment_size ( const ::iovec &v ) { return v.iov_len; }
+#endif
+    }
+
+
+    /// \fn segmented_search ( SegmentIterator first, SegmentIterator last, const Searcher &searcher, std::size_t pattern_length, segment_position start )
+    /// \brief Finds the first match at or after start
+    ///
+    /// \param first, last      The segments, in order
+    /// \param searcher         The matching kernel; any searcher over pointers to the segments' elements
+    /// \param pattern_length   The length of the searcher's pattern
+    /// \param start            Where to start; to find the next match, pass the last one with offset + 1
+    ///
+    /// \return The position of the match, or { number of segments, 0 } if there is none
+    ///
+    template <typename SegmentIterator, typename Searcher>
+    segment_position segmented_search ( SegmentIterator first, SegmentIterator last, const Searcher &searcher,
+                                        std::size_t pattern_length, segment_position start = segment_position ()) {
+        typedef typename std::remove_cv<typename std::remove_pointer<
+                    decltype ( detail::segment_data ( *first ))>::type>::type value_type;
+
+        const std::size_t k_segments = std::distance ( first, last );
+        const segment_position notFound = { k_segments, 0 };
+        if ( start.segment >= k_segments )
+            return notFound;
+        std::advance ( first, start.segment );
+
+        const std::size_t k_overlap = pattern_length > 0 ? pattern_length - 1 : 0;
+        std::vector<value_type> scratch;
+        scratch.reserve ( 2 * k_overlap );
+
+        std::size_t offset = start.offset;
+        for ( std::size_t seg = start.segment; seg < k_segments; ++seg, ++first, offset = 0 ) {
+            const value_type *data = detail::segment_data ( *first );
+            const std::size_t size = detail::segment_size ( *first );
+            if ( offset >= size )
+                continue;
+
+        //  Windows that lie entirely within this segment
+            const value_type *it = searcher ( data + offset, data + size );
+            if ( it != data + size )
+                return segment_position { seg, static_cast<std::size_t> ( it - data ) };
+            if ( k_overlap == 0 )
+                continue;
+
+        //  Windows that start in the last k_overlap elements and run on into the following segments
+            const std::size_t tail = std::min ( k_overlap, size - offset );
+            scratch.assign ( data + size - tail, data + size );
+            SegmentIterator nextSeg = first;
+            for ( ++nextSeg; nextSeg != last && scratch.size () < tail + k_overlap; ++nextSeg ) {
+                const value_type *nData = detail::segment_data ( *nextSeg );
+                const std::size_t nSize = std::min ( detail::segment_size ( *nextSeg ), tail + k_overlap - scratch.size ());
+                scratch.insert ( scratch.end (), nData, nData + nSize );
+                }
+            if ( scratch.size () == tail )
+                continue;       // nothing follows this segment
+
+            const value_type *sFirst = scratch.data ();
+            const value_type *sLast  = sFirst + scratch.size ();
+            const value_type *hit = searcher ( sFirst, sLast );
+        //  A match starting past the tail belongs to a later segment, and will be found there
+            if ( hit != sLast && static_cast<std::size_t> ( hit - sFirst ) < tail )
+                return segment_position { seg, size - tail + static_cast<std::size_t> ( hit - sFirst ) };
+            }
+
+        return notFound;
+        }
+}
+
+#endif // TBA_SEGMENTED_SEARCH_HPP
@@ -0,0 +1,306 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  A suffix array index over a static corpus.
+//
+//  The index is built once, in O(n log n) time, and then answers queries in
+//  time that depends on the pattern (and, for locate_all, on the number of
+//  matches) rather than on the size of the corpus:
+//      count       O(m log n) worst case, close to O(m + log n) in practice
+//      find_first  count, plus O(1) range-minimum query
+//      locate_all  count, plus O(occ log occ)
+//
+//  The index refers to the corpus through the iterators it was built with;
+//  the corpus must outlive the index and must not change.
+//
+
+#ifndef TBA_SUFFIX_ARRAY_HPP
+#define TBA_SUFFIX_ARRAY_HPP
+
+#include "searching.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace tba {
+
+    template <typename RandomAccessIterator, typename Index = std::uint32_t>
+    class suffix_array_index;
+
+//  A searcher-like view of one pattern in an index, so that an index can be
+//  used with tba::search. The corpus passed to operator () must be the range
+//  the index was built over.
+    template <typename RandomAccessIterator, typename Index, typename PatternIterator>
+    class suffix_array_searcher {
+    public:
+        suffix_array_searcher ( const suffix_array_index<RandomAccessIterator, Index> &index,
+                                PatternIterator first, PatternIterator last )
+            : index_ ( &index ), first_ ( first ), last_ ( last ) {}
+
+        template <typename CorpusIterator>
+        CorpusIterator operator () ( CorpusIterator cFirst, CorpusIterator cLast ) const {
+            assert ( static_cast<std::size_t> ( std::distance ( cFirst, cLast )) == index_->size ());
+            const std::size_t pos = index_->find_first ( first_, last_ );
+            return pos == index_->npos ? cLast : cFirst + pos;
+            }
+
+        template <typename CorpusIterator>
+        std::size_t count ( CorpusIterator cFirst, CorpusIterator cLast, count_mode mode = count_mode::overlapping ) const {
+            assert ( static_cast<std::size_t> ( std::distance ( cFirst, cLast )) == index_->size ());
+            if ( mode == count_mode::overlapping || first_ == last_ )
+                return index_->count ( first_, last_ );
+
+        //  Greedily keep the matches that start at or after the end of the previous one
+            const std::size_t m = std::distance ( first_, last_ );
+            const std::vector<std::size_t> all = index_->locate_all ( first_, last_ );
+            std::size_t retVal = 0;
+            std::size_t next = 0;
+            for ( std::size_t i = 0; i < all.size (); ++i )
+                if ( all [ i ] >= next ) {
+                    ++retVal;
+                    next = all [ i ] + m;
+                    }
+            return retVal;
+            }
+
+    private:
+        const suffix_array_index<RandomAccessIterator, Index> *index_;
+        PatternIterator first_;
+        PatternIterator last_;
+        };
+
+
+    template <typename RandomAccessIterator, typename Index>
+    class suffix_array_index {
+        typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+        static const std::size_t k_block = 64;      // granularity of the range-minimum table
+    public:
+        static const std::size_t npos = static_cast<std::size_t> ( -1 );
+
+        suffix_array_index ( RandomAccessIterator first, RandomAccessIterator last )
+                : first_ ( first ), k_corpus_length ( std::distance ( first, last )) {
+            if ( k_corpus_length >= static_cast<std::size_t> ( std::numeric_limits<Index>::max ()))
+                throw std::length_error ( "suffix_array_index: corpus too large for the index type" );
+            this->build_suffix_array ();
+            this->build_min_table ();
+            }
+
+        std::size_t size () const { return k_corpus_length; }
+
+        /// \fn equal_range ( PatternIterator first, PatternIterator last )
+        /// \brief Returns the [begin, end) range of suffix array slots whose suffixes start with the pattern
+        ///
+        template <typename PatternIterator>
+        std::pair<std::size_t, std::size_t> equal_range ( PatternIterator first, PatternIterator last ) const {
+            const std::size_t lo = this->bound ( first, last, false );
+            const std::size_t hi = this->bound ( first, last, true );
+            return std::make_pair ( lo, hi );
+            }
+
+        /// \fn count ( PatternIterator first, PatternIterator last )
+        /// \brief Returns the number of (possibly overlapping) occurrences of the pattern
+        ///
+        template <typename PatternIterator>
+        std::size_t count ( PatternIterator first, PatternIterator last ) const {
+            const std::pair<std::size_t, std::size_t> r = this->equal_range ( first, last );
+            return r.second - r.first;
+            }
+
+        /// \fn find_first ( PatternIterator first, PatternIterator last )
+        /// \brief Returns the offset of the first occurrence of the pattern, or npos
+        ///
+        template <typename PatternIterator>
+        std::size_t find_first ( PatternIterator first, PatternIterator last ) const {
+            if ( first == last ) return 0;      // empty pattern matches at start
+            const std::pair<std::size_t, std::size_t> r = this->equal_range ( first, last );
+            return r.first == r.second ? npos : this->range_min ( r.first, r.second );
+            }
+
+        /// \fn locate_all ( PatternIterator first, PatternIterator last )
+        /// \brief Returns the offsets of every occurrence of the pattern, in increasing order
+        ///
+        template <typename PatternIterator>
+        std::vector<std::size_t> locate_all ( PatternIterator first, PatternIterator last ) const {
+            const std::pair<std::size_t, std::size_t> r = this->equal_range ( first, last );
+            std::vector<std::size_t> retVal ( sa_.begin () + r.first, sa_.begin () + r.second );
+            std::sort ( retVal.begin (), retVal.end ());
+            return retVal;
+            }
+
+        template <typename PatternIterator>
+        suffix_array_searcher<RandomAccessIterator, Index, PatternIterator>
+        searcher ( PatternIterator first, PatternIterator last ) const {
+            return suffix_array_searcher<RandomAccessIterator, Index, PatternIterator> ( *this, first, last );
+            }
+
+        /// \brief The number of bytes of memory used by the index (not counting the corpus)
+        std::size_t memory_usage () const {
+            std::size_t retVal = sa_.capacity () * sizeof ( Index );
+            for ( std::size_t i = 0; i < min_table_.size (); ++i )
+                retVal += min_table_ [ i ].capacity () * sizeof ( Index );
+            return retVal;
+            }
+
+    private:
+        RandomAccessIterator first_;
+        const std::size_t k_corpus_length;
+        std::vector<Index> sa_;
+    //  min_table_[k][b] is the smallest suffix array entry in blocks [b, b + 2^k)
+        std::vector<std::vector<Index>> min_table_;
+
+    //  Prefix doubling (Manber & Myers), with a counting sort on each round
+        void build_suffix_array () {
+            const std::size_t n = k_corpus_length;
+            sa_.resize ( n );
+            if ( n == 0 ) return;
+
+            std::vector<Index> rank ( n ), tmp ( n );
+            for ( std::size_t i = 0; i < n; ++i )
+                sa_ [ i ] = static_cast<Index> ( i );
+            std::sort ( sa_.begin (), sa_.end (), [this] ( Index a, Index b ) { return first_ [ a ] < first_ [ b ]; });
+
+            std::size_t classes = 1;
+            rank [ sa_ [ 0 ]] = 0;
+            for ( std::size_t i = 1; i < n; ++i ) {
+                if ( first_ [ sa_ [ i - 1 ]] < first_ [ sa_ [ i ]] )
+                    ++classes;
+                rank [ sa_ [ i ]] = static_cast<Index> ( classes - 1 );
+                }
+
+            std::vector<Index> counts;
+            for ( std::size_t k = 1; classes < n; k <<= 1 ) {
+            //  Order by the second half: suffixes without one come first
+                std::size_t p = 0;
+                for ( std::size_t i = n - std::min ( k, n ); i < n; ++i )
+                    tmp [ p++ ] = static_cast<Index> ( i );
+                for ( std::size_t i = 0; i < n; ++i )
+                    if ( sa_ [ i ] >= k )
+                        tmp [ p++ ] = static_cast<Index> ( sa_ [ i ] - k );
+
+            //  Then stable counting sort by the first half
+                counts.assign ( classes + 1, 0 );
+                for ( std::size_t i = 0; i < n; ++i )
+                    ++counts [ rank [ i ] + 1 ];
+                for ( std::size_t c = 1; c <= classes; ++c )
+                    counts [ c ] += counts [ c - 1 ];
+                for ( std::size_t i = 0; i < n; ++i )
+                    sa_ [ counts [ rank [ tmp [ i ]]]++ ] = tmp [ i ];
+
+            //  Re-rank; tmp holds the new ranks
+                tmp [ sa_ [ 0 ]] = 0;
+                classes = 1;
+                for ( std::size_t i = 1; i < n; ++i ) {
+                    const std::size_t a = sa_ [ i - 1 ], b = sa_ [ i ];
+                    const std::size_t a2 = a + k < n ? rank [ a + k ] + std::size_t ( 1 ) : 0;
+                    const std::size_t b2 = b + k < n ? rank [ b + k ] + std::size_t ( 1 ) : 0;
+                    if ( rank [ a ] != rank [ b ] || a2 != b2 )
+                        ++classes;
+                    tmp [ b ] = static_cast<Index> ( classes - 1 );
+                    }
+                rank.swap ( tmp );
+                }
+            }
+
+        void build_min_table () {
+            const std::size_t blocks = ( k_corpus_length + k_block - 1 ) / k_block;
+            if ( blocks == 0 ) return;
+
+            min_table_.push_back ( std::vector<Index> ( blocks ));
+            for ( std::size_t b = 0; b < blocks; ++b ) {
+                const std::size_t end = std::min ( k_corpus_length, ( b + 1 ) * k_block );
+                min_table_ [ 0 ] [ b ] = *std::min_element ( sa_.begin () + b * k_block, sa_.begin () + end );
+                }
+
+            for ( std::size_t k = 1; ( std::size_t ( 1 ) << k ) <= blocks; ++k ) {
+                const std::vector<Index> &prev = min_table_ [ k - 1 ];
+                const std::size_t half = std::size_t ( 1 ) << ( k - 1 );
+                std::vector<Index> row ( blocks - 2 * half + 1 );
+                for ( std::size_t b = 0; b < row.size (); ++b )
+                    row [ b ] = std::min ( prev [ b ], prev [ b + half ] );
+                min_table_.push_back ( std::move ( row ));
+                }
+            }
+
+    //  The smallest entry of sa_[lo, hi): partial blocks are scanned, whole blocks use the table
+        std::size_t range_min ( std::size_t lo, std::size_t hi ) const {
+            const std::size_t first_block = ( lo + k_block - 1 ) / k_block;
+            const std::size_t last_block  = hi / k_block;
+            if ( first_block >= last_block )
+                return *std::min_element ( sa_.begin () + lo, sa_.begin () + hi );
+
+            Index retVal = std::numeric_limits<Index>::max ();
+            if ( lo < first_block * k_block )
+                retVal = *std::min_element ( sa_.begin () + lo, sa_.begin () + first_block * k_block );
+            if ( last_block * k_block < hi )
+                retVal = std::min ( retVal, *std::min_element ( sa_.begin () + last_block * k_block, sa_.begin () + hi ));
+
+            std::size_t k = 0;
+            while (( std::size_t ( 2 ) << k ) <= last_block - first_block )
+                ++k;
+            retVal = std::min ( retVal, std::min ( min_table_ [ k ] [ first_block ],
+                                                   min_table_ [ k ] [ last_block - ( std::size_t ( 1 ) << k ) ] ));
+            return retVal;
+            }
+
+    //  Compares the pattern with the suffix at pos, skipping the first `matched` elements,
+    //  which are already known to be equal. Returns <0, 0 or >0, and updates `matched`.
+        template <typename PatternIterator>
+        int compare ( PatternIterator first, std::size_t m, std::size_t pos, std::size_t &matched ) const {
+            const std::size_t avail = k_corpus_length - pos;
+            PatternIterator p = first;
+            std::advance ( p, matched );
+            while ( matched < m ) {
+                if ( matched == avail )
+                    return 1;       // the suffix is a proper prefix of the pattern
+                const value_type &c = first_ [ pos + matched ];
+                if ( *p < c ) return -1;
+                if ( c < *p ) return 1;
+                ++matched;
+                ++p;
+                }
+            return 0;
+            }
+
+    //  Binary search for the first slot whose suffix is >= the pattern (or > it, when upper is true),
+    //  comparing only the first m elements of each suffix. The smaller of the matched lengths
+    //  at the two ends of the range is known to match at the midpoint, so it is skipped.
+        template <typename PatternIterator>
+        std::size_t bound ( PatternIterator first, PatternIterator last, bool upper ) const {
+            const std::size_t m = std::distance ( first, last );
+            std::size_t lo = 0, hi = k_corpus_length;
+            std::size_t lo_lcp = 0, hi_lcp = 0;
+            while ( lo < hi ) {
+                const std::size_t mid = lo + ( hi - lo ) / 2;
+                std::size_t matched = std::min ( lo_lcp, hi_lcp );
+                const int cmp = this->compare ( first, m, sa_ [ mid ], matched );
+                if ( cmp > 0 || ( upper && cmp == 0 )) {
+                    lo = mid + 1;
+                    lo_lcp = matched;
+                    }
+                else {
+                    hi = mid;
+                    hi_lcp = matched;
+                    }
+                }
+            return lo;
+            }
+        };
+
+    template <typename RandomAccessIterator, typename Index>
+    const std::size_t suffix_array_index<RandomAccessIterator, Index>::npos;
+
+
+template <typename RandomAccessIterator>
+suffix_array_index<RandomAccessIterator> make_suffix_array_index ( RandomAccessIterator first, RandomAccessIterator last ) {
+	return suffix_array_index<RandomAccessIterator> ( first, last );
+	}
+}
+
+#endif // TBA_SUFFIX_ARRAY_HPP
@@ -24,9 +24,15 @@ template<typename Iterator>
 struct map_BM_traits {
 	typedef typename std::iterator_traits<Iterator>::difference_type value_type;
 	typedef typename std::iterator_traits<Iterator>::value_type key_type;
-	typedef tba::skip_table<key_type, value_type, false> skip_table_t;
+	typedef tba::skip_table<key_type, value_type, std::hash<key_type>, std::equal_to<key_type>, false> skip_table_t;
 	};
 
+template<typename Container>
+using map_hash = std::hash<typename Container::value_type>;
+
+template<typename Container>
+using map_equal = std::equal_to<typename Container::value_type>;
+
 
 template <typename vec>
 vec ReadFromFile ( const char *name ) {
@@ -102,7 +108,8 @@ template <typename Container>
 duration bm_search_map ( const Container &haystack, const Container &needle, int expected ) {
 	auto start = std::chrono::high_resolution_clock::now ();
 	int ret = OverAndOver ( haystack, 
-	       tba::make_boyer_moore_searcher<typename Container::const_iterator, map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
+	       tba::make_boyer_moore_searcher<typename Container::const_iterator, map_hash<Container>, map_equal<Container>,
+				map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
 	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
 	if ( ret != expected )
 		std::cerr << "Unexpected return from boyer_moore(map); got " << ret << ", expected " << expected << std::endl;
@@ -128,7 +135,8 @@ template <typename Container>
 duration bmh_search_map ( const Container &haystack, const Container &needle, int expected ) {
 	auto start = std::chrono::high_resolution_clock::now ();
 	int ret = OverAndOver ( haystack, 
-	       tba::make_boyer_moore_horspool_searcher<typename Container::const_iterator, map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
+	       tba::make_boyer_moore_horspool_searcher<typename Container::const_iterator, map_hash<Container>, map_equal<Container>,
+				map_BM_traits<typename Container::const_iterator>> ( needle.begin (), needle.end ()));
 	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
 	if ( ret != expected )
 		std::cerr << "Unexpected return from boyer_moore(map); got " << ret << ", expected " << expected << std::endl;
@@ -137,6 +145,42 @@ duration bmh_search_map ( const Container &haystack, const Container &needle, in
 
 // -----
 
+template <typename Container>
+duration sunday_search ( const Container &haystack, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	int ret = OverAndOver ( haystack, tba::make_sunday_searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( ret != expected )
+		std::cerr << "Unexpected return from sunday; got " << ret << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+// -----
+
+template <typename Container>
+duration raita_search ( const Container &haystack, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	int ret = OverAndOver ( haystack, tba::make_raita_searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( ret != expected )
+		std::cerr << "Unexpected return from raita; got " << ret << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+// -----
+
+template <typename Container>
+duration rare_byte_search ( const Container &haystack, const Container &needle, int expected ) {
+	auto start = std::chrono::high_resolution_clock::now ();
+	int ret = OverAndOver ( haystack, tba::make_rare_byte_searcher ( needle.begin (), needle.end ()));
+	duration elapsed = std::chrono::duration_cast<duration> ( std::chrono::high_resolution_clock::now () - start );
+	if ( ret != expected )
+		std::cerr << "Unexpected return from rare_byte; got " << ret << ", expected " << expected << std::endl;
+	return elapsed;
+	}
+
+// -----
+
 template <typename T>
 double dur_pct ( T whole, T part ) { return 100 * double (part.count ()) / double (whole.count ()); }
 
@@ -170,10 +214,16 @@ void check_one (  const Container &haystack, const Container &needle, int where
 	std::cout << "Boyer-Moore-Horspool search took:       " << bmh.count ()    << "\t(" << dur_pct ( stds, bmh ) << ")" << std::endl;
 	duration bmh_map = bmh_search_map ( haystack, needle, expected );
 	std::cout << "Boyer-Moore-Horspool (map) search took: " << bmh_map.count ()<< "\t(" << dur_pct ( stds, bmh_map ) << ")" << std::endl;
+	duration sunday = sunday_search ( haystack, needle, expected );
+	std::cout << "Sunday search took:                     " << sunday.count () << "\t(" << dur_pct ( stds, sunday ) << ")" << std::endl;
+	duration raita = raita_search ( haystack, needle, expected );
+	std::cout << "Raita search took:                      " << raita.count ()  << "\t(" << dur_pct ( stds, raita ) << ")" << std::endl;
+	duration rare = rare_byte_search ( haystack, needle, expected );
+	std::cout << "Rare byte search took:                  " << rare.count ()   << "\t(" << dur_pct ( stds, rare ) << ")" << std::endl;
 	}
 
 int main ( int argc, char *argv[] ) {
-    std::cout << std::ios::fixed << std::setprecision(4);
+    std::cout << std::fixed << std::setprecision(4);
 
 	typedef std::vector<char> vec;
     vec c1  = ReadFromFile<vec> ( "data/0001.corpus" );
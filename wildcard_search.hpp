@@ -0,0 +1,327 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Searching byte sequences for patterns with wildcards, byte classes and bounded gaps.
+//
+//  The pattern language:
+//      c           a literal byte
+//      \c          c itself, even if it is one of ? [ ] { } \ ;  \xHH is the byte 0xHH
+//      ?           any byte
+//      [...]       any byte in the class: single bytes and ranges such as 0-9A-F
+//      [^...]      any byte not in the class
+//      e{n}        exactly n copies of the element e
+//      e{n,m}      between n and m copies of e; so ?{2,5} is a gap of 2 to 5 bytes
+//
+//  A pattern is compiled into at most 63 positions (after expanding the
+//  repeats), and the corpus is scanned with bit-parallel Shift-And, with an
+//  epsilon closure for the optional positions. If the pattern has a literal
+//  run of two or more bytes, contiguous corpora are first scanned for that
+//  literal with the SIMD kernel from searching.hpp, and only the places where
+//  it occurs are checked against the whole pattern.
+//
+//  Like every other searcher, wildcard_searcher returns the start of the
+//  first (leftmost) match.
+//
+
+#ifndef TBA_WILDCARD_SEARCH_HPP
+#define TBA_WILDCARD_SEARCH_HPP
+
+#include "searching.hpp"
+
+#include <bitset>
+#include <cctype>
+#include <string>
+
+namespace tba {
+
+    class wildcard_searcher {
+        typedef std::uint64_t mask_type;
+    public:
+        static const std::size_t k_max_positions = 63;     // one bit is the start state
+
+        template <typename ForwardIterator>
+        wildcard_searcher ( ForwardIterator first, ForwardIterator last )
+                : masks_ (), optional_ ( 0 ), positions_ ( 0 ), min_length_ ( 0 ), max_run_ ( 0 ),
+                  anchor_min_ ( 0 ), anchor_max_ ( 0 ) {
+            this->compile ( std::string ( first, last ));
+            }
+
+        /// \fn operator ( corpusIter corpus_first, corpusIter corpus_last )
+        /// \brief Searches the corpus for the pattern that was passed into the constructor
+        ///
+        /// \param corpus_first The start of the data to search (Random Access Iterator)
+        /// \param corpus_last  One past the end of the data to search
+        ///
+        template <typename RandomAccessIterator>
+        RandomAccessIterator
+        operator () ( RandomAccessIterator corpus_first, RandomAccessIterator corpus_last ) const {
+            static_assert ( sizeof ( typename std::iterator_traits<RandomAccessIterator>::value_type ) == 1,
+                    "wildcard_searcher only searches byte sequences" );
+
+            if ( corpus_first == corpus_last ) return corpus_last;  // if nothing to search, we didn't find it!
+            if ( min_length_ == 0 )            return corpus_first; // a pattern that can be empty matches at start
+
+        //  If the pattern is larger than the corpus, we can't find it!
+            if ( static_cast<std::size_t> ( std::distance ( corpus_first, corpus_last )) < min_length_ )
+                return corpus_last;
+
+            return this->do_search ( corpus_first, corpus_last,
+                std::integral_constant<bool, detail::is_contiguous_bytes<RandomAccessIterator>::value> ());
+            }
+
+        /// \brief The shortest and longest lengths of a match
+        std::size_t min_length () const { return min_length_; }
+        std::size_t max_length () const { return positions_; }
+
+    private:
+    //  Bit i + 1 of masks_ [c] is set if position i accepts c; bit 0 is the start state
+        std::array<mask_type, 256> masks_;
+        mask_type optional_;            // bit i + 1 is set if position i may be skipped
+        std::size_t positions_;
+        std::size_t min_length_;
+        std::size_t max_run_;           // the longest run of optional positions
+        std::string anchor_;            // the longest literal run, if any
+        std::size_t anchor_min_;        // how far into a match the anchor can start
+        std::size_t anchor_max_;
+
+        mask_type accept () const { return mask_type ( 1 ) << positions_; }
+
+    //  Let active states skip over optional positions
+        mask_type closure ( mask_type d ) const {
+            for ( std::size_t i = 0; i < max_run_; ++i )
+                d |= ( d << 1 ) & optional_;
+            return d;
+            }
+
+    //  Does a match start at start?
+        template <typename Iterator>
+        bool match_at ( Iterator start, Iterator corpus_last ) const {
+            mask_type d = this->closure ( 1 );
+            for ( ; ( d & this->accept ()) == 0; ++start ) {
+                if ( start == corpus_last )
+                    return false;
+                d = this->closure (( d << 1 ) & masks_ [ static_cast<unsigned char> ( *start ) ] );
+                if ( d == 0 )
+                    return false;
+                }
+            return true;
+            }
+
+    //  The first start in [from, to] (clipped to the corpus) where a match begins
+        template <typename Iterator>
+        Iterator first_match_in ( Iterator corpus_first, Iterator corpus_last, std::size_t from, std::size_t to ) const {
+            for ( Iterator it = std::next ( corpus_first, from ); from <= to; ++from, ++it )
+                if ( this->match_at ( it, corpus_last ))
+                    return it;
+            return corpus_last;
+            }
+
+    //  Shift-And over the whole corpus. When a match is seen to end, the leftmost
+    //  start is among the few places a match of legal length could begin.
+        template <typename Iterator>
+        Iterator do_search ( Iterator corpus_first, Iterator corpus_last, std::false_type ) const {
+            const mask_type k_accept = this->accept ();
+            mask_type d = this->closure ( 1 );
+            std::size_t pos = 0;
+            for ( Iterator it = corpus_first; it != corpus_last; ++it, ++pos ) {
+                d = (( d << 1 ) & masks_ [ static_cast<unsigned char> ( *it ) ] ) | 1;
+                if ( max_run_ > 0 )
+                    d = this->closure ( d );
+                if ( d & k_accept ) {
+                    const std::size_t end = pos + 1;
+                    const std::size_t from = end > positions_ ? end - positions_ : 0;
+                    const Iterator found = this->first_match_in ( corpus_first, corpus_last, from, end - min_length_ );
+                    assert ( found != corpus_last );
+                    return found;
+                    }
+                }
+            return corpus_last;
+            }
+
+    //  Contiguous bytes: find the anchor with the SIMD kernel, then check the starts it allows
+        template <typename Iterator>
+        Iterator do_search ( Iterator corpus_first, Iterator corpus_last, std::true_type ) const {
+            if ( anchor_.size () < 2 )
+                return this->do_search ( corpus_first, corpus_last, std::false_type ());
+
+            const unsigned char *s = reinterpret_cast<const unsigned char *> ( &*corpus_first );
+            const std::size_t n = std::distance ( corpus_first, corpus_last );
+            const unsigned char *a = reinterpret_cast<const unsigned char *> ( anchor_.data ());
+            std::size_t next_start = 0;         // every start before this has been checked
+            for ( std::size_t q = anchor_min_; q < n; ) {
+                const std::size_t hit = q + detail::find_bytes ( s + q, n - q, a, anchor_.size ());
+                if ( hit >= n )
+                    break;
+                const std::size_t from = std::max ( next_start, hit > anchor_max_ ? hit - anchor_max_ : 0 );
+                const std::size_t to   = hit - anchor_min_;
+                if ( from + min_length_ > n )
+                    break;          // no room left for a match
+                if ( from <= to ) {
+                    const Iterator found = this->first_match_in ( corpus_first, corpus_last, from, to );
+                    if ( found != corpus_last )
+                        return found;
+                    next_start = to + 1;
+                    }
+                q = hit + 1;
+                }
+            return corpus_last;
+            }
+
+    //  An element of the pattern: the set of bytes it accepts, and how often it repeats
+        struct element {
+            std::bitset<256> bytes;
+            std::size_t min_count;
+            std::size_t max_count;
+            };
+
+        static unsigned char parse_byte ( const std::string &pat, std::size_t &i ) {
+            if ( pat [ i ] != '\\' )
+                return static_cast<unsigned char> ( pat [ i++ ] );
+            if ( ++i == pat.size ())
+                throw std::invalid_argument ( "wildcard_searcher: pattern ends with \\" );
+            if ( pat [ i ] != 'x' )
+                return static_cast<unsigned char> ( pat [ i++ ] );
+
+            unsigned value = 0;
+            for ( int digits = 0; digits < 2; ++digits ) {
+                if ( ++i == pat.size () || !std::isxdigit ( static_cast<unsigned char> ( pat [ i ] )))
+                    throw std::invalid_argument ( "wildcard_searcher: \\x needs two hex digits" );
+                const char c = static_cast<char> ( std::tolower ( static_cast<unsigned char> ( pat [ i ] )));
+                value = value * 16 + ( c <= '9' ? c - '0' : c - 'a' + 10 );
+                }
+            ++i;
+            return static_cast<unsigned char> ( value );
+            }
+
+        static std::bitset<256> parse_class ( const std::string &pat, std::size_t &i ) {
+            std::bitset<256> retVal;
+            const bool negate = i < pat.size () && pat [ i ] == '^';
+            if ( negate )
+                ++i;
+            for ( bool first = true; ; first = false ) {
+                if ( i == pat.size ())
+                    throw std::invalid_argument ( "wildcard_searcher: unterminated [" );
+                if ( pat [ i ] == ']' && !first )
+                    break;
+                const unsigned char lo = parse_byte ( pat, i );
+                unsigned char hi = lo;
+                if ( i + 1 < pat.size () && pat [ i ] == '-' && pat [ i + 1 ] != ']' ) {
+                    ++i;
+                    hi = parse_byte ( pat, i );
+                    if ( hi < lo )
+                        throw std::invalid_argument ( "wildcard_searcher: bad range in class" );
+                    }
+                for ( unsigned c = lo; c <= hi; ++c )
+                    retVal.set ( c );
+                }
+            ++i;    // the ]
+            return negate ? ~retVal : retVal;
+            }
+
+        static std::size_t parse_number ( const std::string &pat, std::size_t &i ) {
+            if ( i == pat.size () || !std::isdigit ( static_cast<unsigned char> ( pat [ i ] )))
+                throw std::invalid_argument ( "wildcard_searcher: expected a number in {}" );
+            std::size_t retVal = 0;
+            for ( ; i < pat.size () && std::isdigit ( static_cast<unsigned char> ( pat [ i ] )); ++i ) {
+                retVal = retVal * 10 + ( pat [ i ] - '0' );
+                if ( retVal > k_max_positions )
+                    throw std::length_error ( "wildcard_searcher: pattern has too many positions" );
+                }
+            return retVal;
+            }
+
+        static std::vector<element> parse ( const std::string &pat ) {
+            std::vector<element> retVal;
+            for ( std::size_t i = 0; i < pat.size (); ) {
+                element e;
+                e.min_count = e.max_count = 1;
+                switch ( pat [ i ] ) {
+                    case '?': e.bytes.set (); ++i; break;
+                    case '[': ++i; e.bytes = parse_class ( pat, i ); break;
+                    case '{':
+                    case '}':
+                    case ']': throw std::invalid_argument ( std::string ( "wildcard_searcher: unexpected " ) + pat [ i ] );
+                    default:  e.bytes.set ( parse_byte ( pat, i )); break;
+                    }
+
+                if ( i < pat.size () && pat [ i ] == '{' ) {
+                    ++i;
+                    e.min_count = e.max_count = parse_number ( pat, i );
+                    if ( i < pat.size () && pat [ i ] == ',' ) {
+                        ++i;
+                        e.max_count = parse_number ( pat, i );
+                        }
+                    if ( i == pat.size () || pat [ i ] != '}' )
+                        throw std::invalid_argument ( "wildcard_searcher: unterminated {" );
+                    ++i;
+                    if ( e.max_count < e.min_count )
+                        throw std::invalid_argument ( "wildcard_searcher: bad repeat count" );
+                    }
+                retVal.push_back ( e );
+                }
+            return retVal;
+            }
+
+        void compile ( const std::string &pat ) {
+            const std::vector<element> elements = parse ( pat );
+
+            std::size_t run = 0;                // the current run of optional positions
+            std::string literal;                // the current literal run
+            std::size_t literal_min = 0, literal_max = 0;
+            for ( std::size_t e = 0; e < elements.size (); ++e ) {
+                const bool single = elements [ e ].bytes.count () == 1;
+                unsigned only = 0;
+                while ( single && !elements [ e ].bytes.test ( only ))
+                    ++only;
+                for ( std::size_t k = 0; k < elements [ e ].max_count; ++k ) {
+                    if ( positions_ == k_max_positions )
+                        throw std::length_error ( "wildcard_searcher: pattern has too many positions" );
+                    const bool optional = k >= elements [ e ].min_count;
+                    const mask_type bit = mask_type ( 1 ) << ( positions_ + 1 );
+                    for ( unsigned c = 0; c < 256; ++c )
+                        if ( elements [ e ].bytes.test ( c ))
+                            masks_ [ c ] |= bit;
+
+                //  Track the longest run of mandatory single bytes, and where it can fall in a match
+                    if ( single && !optional ) {
+                        if ( literal.empty ()) {
+                            literal_min = min_length_;
+                            literal_max = positions_;
+                            }
+                        literal.push_back ( static_cast<char> ( only ));
+                        if ( literal.size () > anchor_.size ()) {
+                            anchor_ = literal;
+                            anchor_min_ = literal_min;
+                            anchor_max_ = literal_max;
+                            }
+                        }
+                    else
+                        literal.clear ();
+
+                    if ( optional ) {
+                        optional_ |= bit;
+                        max_run_ = std::max ( max_run_, ++run );
+                        }
+                    else {
+                        run = 0;
+                        ++min_length_;
+                        }
+                    ++positions_;
+                    }
+                }
+            }
+        };
+
+
+template <typename ForwardIterator>
+wildcard_searcher make_wildcard_searcher ( ForwardIterator first, ForwardIterator last ) {
+	return wildcard_searcher ( first, last );
+	}
+}
+
+#endif // TBA_WILDCARD_SEARCH_HPP
@@ -0,0 +1,395 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//
+//  Corpora for the benchmark programs.
+//
+//  Uniformly random bytes are the kindest possible input for a skip-based
+//  searcher: almost every alignment is rejected by its first comparison, and
+//  the skips are nearly as long as the pattern. Real traffic is not like that.
+//  corpus_generator produces, a buffer at a time:
+//
+//      uniform     bytes 0x00 - 0xFE
+//      zipf_text   words drawn from a Zipf-distributed vocabulary, with spaces, '.' and '\n'
+//      dna         'A', 'C', 'G', 'T'
+//      binary      0x00 and 0x01
+//      periodic    a short random period repeated, with a rare mutation
+//      adversarial 'a', with a rare 'b'; a pattern a..aXa..a makes every
+//                  searcher compare about half of it at nearly every alignment
+//
+//  The output depends only on the kind and the seed (not on the platform, or on
+//  how it is split into buffers), so a corpus of tens of GB never has to be stored.
+//  Copies of a pattern can be planted at a given density. No corpus ever
+//  contains k_absent_byte, so make_absent_pattern () builds a pattern that looks
+//  like the corpus but is guaranteed not to occur in it.
+//
+
+#ifndef TBA_WORKLOAD_HPP
+#define TBA_WORKLOAD_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tba {
+namespace workload {
+
+    enum class corpus_kind { uniform, zipf_text, dna, binary, periodic, adversarial };
+
+    const corpus_kind all_kinds [] = {
+        corpus_kind::uniform, corpus_kind::zipf_text, corpus_kind::dna,
+        corpus_kind::binary, corpus_kind::periodic, corpus_kind::adversarial };
+
+    inline const char *kind_name ( corpus_kind kind ) {
+        switch ( kind ) {
+            case corpus_kind::uniform:      return "uniform";
+            case corpus_kind::zipf_text:    return "zipf_text";
+            case corpus_kind::dna:          return "dna";
+            case corpus_kind::binary:       return "binary";
+            case corpus_kind::periodic:     return "periodic";
+            case corpus_kind::adversarial:  return "adversarial";
+            }
+        return "unknown";
+        }
+
+//  No generator ever produces this byte
+    const unsigned char k_absent_byte = 0xFF;
+
+namespace detail {
+//  splitmix64; unlike the <random> distributions, its output is the same everywhere
+    class random_source {
+    public:
+        explicit random_source ( std::uint64_t seed ) : state_ ( seed ) {}
+
+        std::uint64_t next () {
+            std::uint64_t z = ( state_ += 0x9E3779B97F4A7C15ULL );
+            z = ( z ^ ( z >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+            z = ( z ^ ( z >> 27 )) * 0x94D049BB133111EBULL;
+            return z ^ ( z >> 31 );
+            }
+
+    //  In [0, n); the bias is at most n / 2^32
+        std::uint32_t below ( std::uint32_t n ) {
+            return static_cast<std::uint32_t> ((( next () >> 32 ) * n ) >> 32 );
+            }
+
+    //  In (0, 1]
+        double unit () {
+            return static_cast<double> (( next () >> 11 ) + 1 ) * ( 1.0 / 9007199254740992.0 );
+            }
+
+    private:
+        std::uint64_t state_;
+        };
+    }
+
+    class corpus_generator {
+    public:
+        static const std::size_t k_vocabulary   = 10000;    // zipf_text: distinct words
+        static const std::size_t k_slot         = 16;       // zipf_text: room for a word and its punctuation
+        static const std::size_t k_period       = 29;       // periodic: length of the period
+        static const std::uint32_t k_mutation   = 4096;     // periodic: one byte in this many is changed
+        static const std::uint32_t k_rare       = 8192;     // adversarial: one byte in this many is a 'b'
+
+        /// \param kind     What to generate
+        /// \param seed     The same kind and seed always give the same corpus
+        ///
+        corpus_generator ( corpus_kind kind, std::uint64_t seed = 1 )
+            : kind_ ( kind ), rng_ ( seed ^ ( static_cast<std::uint64_t> ( kind ) << 56 )),
+              pos_ ( 0 ), bits_ ( 0 ), nbits_ ( 0 ), word_pos_ ( 0 ), period_pos_ ( 0 ), to_mutation_ ( 0 ),
+              plant_rng_ ( 0 ), next_plant_ ( 0 ), mean_gap_ ( 0 ), planted_ ( 0 ) {
+            if ( kind_ == corpus_kind::zipf_text ) {
+            //  P ( rank r ) is proportional to 1 / r. Sample it with Vose's alias method:
+            //  pick a column uniformly, then keep it with probability keep_ [ col ] / 2^28,
+            //  or take alias_ [ col ] instead.
+                double total = 0;
+                for ( std::size_t r = 1; r <= k_vocabulary; ++r )
+                    total += 1.0 / static_cast<double> ( r );
+                std::vector<double> scaled ( k_vocabulary );
+                std::vector<std::size_t> small, large;
+                for ( std::size_t r = 0; r < k_vocabulary; ++r ) {
+                    scaled [ r ] = k_vocabulary / ( total * static_cast<double> ( r + 1 ));
+                    ( scaled [ r ] < 1 ? small : large ).push_back ( r );
+                    }
+                keep_.assign ( k_vocabulary, std::uint32_t ( 1 ) << 28 );
+                alias_.resize ( k_vocabulary );
+                for ( std::size_t r = 0; r < k_vocabulary; ++r )
+                    alias_ [ r ] = static_cast<std::uint32_t> ( r );
+                while ( !small.empty () && !large.empty ()) {
+                    const std::size_t s = small.back (), l = large.back ();
+                    small.pop_back ();
+                    keep_ [ s ]  = static_cast<std::uint32_t> ( scaled [ s ] * ( std::uint32_t ( 1 ) << 28 ));
+                    alias_ [ s ] = static_cast<std::uint32_t> ( l );
+                    scaled [ l ] -= 1 - scaled [ s ];
+                    if ( scaled [ l ] < 1 ) {
+                        large.pop_back ();
+                        small.push_back ( l );
+                        }
+                    }
+                vocabulary_.assign ( k_vocabulary * k_slot, ' ' );
+                for ( std::size_t i = 0; i < k_vocabulary; ++i ) {
+                //  Common words tend to be short
+                    const std::size_t length = 1 + rng_.below ( 3 + static_cast<std::uint32_t> ( 7 * i / k_vocabulary ))
+                                                 + rng_.below ( 3 );
+                    for ( std::size_t j = 0; j < length; ++j )
+                        vocabulary_ [ i * k_slot + j ] = static_cast<char> ( 'a' + rng_.below ( 26 ));
+                    word_length_.push_back ( static_cast<unsigned char> ( length ));
+                    }
+                }
+            else if ( kind_ == corpus_kind::periodic ) {
+                for ( std::size_t i = 0; i < k_period; ++i )
+                    period_.push_back ( static_cast<char> ( 'a' + rng_.below ( 4 )));
+                }
+            }
+
+        /// \fn plant ( const std::string &pattern, double per_mib, std::uint64_t seed )
+        /// \brief From the current position on, writes copies of pattern over the corpus, on average per_mib per MiB
+        ///
+        /// The copies never overlap each other. Natural occurrences are not removed,
+        /// so a corpus holds at least planted () matches.
+        ///
+        void plant ( const std::string &pattern, double per_mib, std::uint64_t seed = 2 ) {
+            if ( per_mib < 0 )
+                throw std::invalid_argument ( "corpus_generator: negative density" );
+            pattern_ = pattern;
+            mean_gap_ = per_mib > 0 ? 1048576.0 / per_mib : 0;
+            plant_rng_ = detail::random_source ( seed );
+            next_plant_ = pos_;
+            if ( !pattern_.empty () && mean_gap_ > 0 )
+                next_plant_ += gap ();
+            }
+
+        /// \fn fill ( char *buffer, std::size_t size )
+        /// \brief Writes the next size bytes of the corpus
+        void fill ( char *buffer, std::size_t size ) {
+            switch ( kind_ ) {
+                case corpus_kind::uniform:      fill_uniform ( buffer, size );      break;
+                case corpus_kind::zipf_text:    fill_text ( buffer, size );         break;
+                case corpus_kind::dna:          fill_dna ( buffer, size );          break;
+                case corpus_kind::binary:       fill_binary ( buffer, size );       break;
+                case corpus_kind::periodic:     fill_periodic ( buffer, size );     break;
+                case corpus_kind::adversarial:  fill_adversarial ( buffer, size );  break;
+                }
+            overlay ( buffer, size );
+            pos_ += size;
+            }
+
+        /// \brief The number of bytes generated so far
+        std::uint64_t position () const { return pos_; }
+
+        /// \brief The number of planted copies that have been completely written so far
+        std::uint64_t planted () const { return planted_; }
+
+    private:
+        std::uint64_t gap () {
+            return pattern_.size () + static_cast<std::uint64_t> ( -std::log ( plant_rng_.unit ()) * mean_gap_ );
+            }
+
+    //  Copy the parts of the planted patterns that fall in [pos_, pos_ + size)
+        void overlay ( char *buffer, std::size_t size ) {
+            if ( pattern_.empty () || mean_gap_ == 0 )
+                return;
+            const std::uint64_t end = pos_ + size;
+            while ( next_plant_ < end ) {
+                const std::uint64_t from = std::max ( next_plant_, pos_ );
+                const std::uint64_t to   = std::min<std::uint64_t> ( next_plant_ + pattern_.size (), end );
+                std::memcpy ( buffer + ( from - pos_ ), pattern_.data () + ( from - next_plant_ ), to - from );
+                if ( next_plant_ + pattern_.size () > end )
+                    break;          // the rest is written by the next call
+                ++planted_;
+                next_plant_ += gap ();
+                }
+            }
+
+    //  The next width bits of the random stream; width divides 64, and leftover
+    //  bits are kept for the next call, so the output does not depend on the buffer sizes
+        std::uint64_t take ( unsigned width ) {
+            if ( nbits_ == 0 ) {
+                bits_ = rng_.next ();
+                nbits_ = 64;
+                }
+            const std::uint64_t retVal = bits_ & (( std::uint64_t ( 1 ) << width ) - 1 );
+            bits_ >>= width;
+            nbits_ -= width;
+            return retVal;
+            }
+
+        void fill_uniform ( char *buffer, std::size_t size ) {
+            std::size_t i = 0;
+            for ( ; i < size && nbits_ > 0; ++i )
+                buffer [ i ] = static_cast<char> (( take ( 8 ) * 255 ) >> 8 );
+            for ( ; i + 8 <= size; i += 8 ) {
+                std::uint64_t bits = rng_.next ();
+                for ( int j = 0; j < 8; ++j, bits >>= 8 )
+                    buffer [ i + j ] = static_cast<char> ((( bits & 0xFF ) * 255 ) >> 8 );
+                }
+            for ( ; i < size; ++i )
+                buffer [ i ] = static_cast<char> (( take ( 8 ) * 255 ) >> 8 );
+            }
+
+        void fill_text ( char *buffer, std::size_t size ) {
+            std::size_t i = 0;
+        //  Finish the word that the last call stopped in the middle of
+            for ( ; i < size && word_pos_ < word_.size (); ++i )
+                buffer [ i ] = word_ [ word_pos_++ ];
+            while ( i < size ) {
+                const std::uint64_t x = rng_.next ();
+                const std::size_t col = static_cast<std::size_t> ((( x >> 32 ) * k_vocabulary ) >> 32 );
+                const std::size_t r = ( static_cast<std::uint32_t> ( x ) >> 4 ) < keep_ [ col ] ? col : alias_ [ col ];
+                const std::uint32_t p = x & 15;
+                const char *slot = vocabulary_.data () + r * k_slot;
+                const std::size_t length = word_length_ [ r ];
+
+            //  Copy the whole slot (the word and its trailing spaces), then fix up the end of the sentence
+                if ( size - i >= k_slot ) {
+                    std::memcpy ( buffer + i, slot, k_slot );
+                    i += length;
+                    if ( p < 2 ) {
+                        buffer [ i++ ] = '.';
+                        buffer [ i ] = p == 0 ? '\n' : ' ';
+                        }
+                    ++i;
+                    }
+                else {
+                    word_.assign ( slot, length );
+                    word_.append ( p == 0 ? ".\n" : p == 1 ? ". " : " " );
+                    for ( word_pos_ = 0; i < size && word_pos_ < word_.size (); ++i )
+                        buffer [ i ] = word_ [ word_pos_++ ];
+                    }
+                }
+            }
+
+        void fill_dna ( char *buffer, std::size_t size ) {
+            static const char k_bases [] = "ACGT";
+            std::size_t i = 0;
+            for ( ; i < size && nbits_ > 0; ++i )
+                buffer [ i ] = k_bases [ take ( 2 ) ];
+            for ( ; i + 32 <= size; i += 32 ) {
+                std::uint64_t bits = rng_.next ();
+                for ( int j = 0; j < 32; ++j, bits >>= 2 )
+                    buffer [ i + j ] = k_bases [ bits & 3 ];
+                }
+            for ( ; i < size; ++i )
+                buffer [ i ] = k_bases [ take ( 2 ) ];
+            }
+
+        void fill_binary ( char *buffer, std::size_t size ) {
+            std::size_t i = 0;
+            for ( ; i < size && nbits_ > 0; ++i )
+                buffer [ i ] = static_cast<char> ( take ( 1 ));
+            for ( ; i + 64 <= size; i += 64 ) {
+                std::uint64_t bits = rng_.next ();
+                for ( int j = 0; j < 64; ++j, bits >>= 1 )
+                    buffer [ i + j ] = static_cast<char> ( bits & 1 );
+                }
+            for ( ; i < size; ++i )
+                buffer [ i ] = static_cast<char> ( take ( 1 ));
+            }
+
+        void fill_periodic ( char *buffer, std::size_t size ) {
+            for ( std::size_t i = 0; i < size; ) {
+                const std::size_t n = std::min ( period_.size () - period_pos_, size - i );
+                std::memcpy ( buffer + i, period_.data () + period_pos_, n );
+                i += n;
+                period_pos_ = ( period_pos_ + n ) % period_.size ();
+                }
+            mutate ( buffer, size, k_mutation, "abcd" );
+            }
+
+        void fill_adversarial ( char *buffer, std::size_t size ) {
+            std::memset ( buffer, 'a', size );
+            mutate ( buffer, size, k_rare, "b" );
+            }
+
+    //  Sets about one byte in every rate to a letter from alphabet; the gaps are
+    //  geometric, so the cost is per change, not per byte
+        void mutate ( char *buffer, std::size_t size, std::uint32_t rate, const char *alphabet ) {
+            const std::uint32_t letters = static_cast<std::uint32_t> ( std::strlen ( alphabet ));
+            for ( std::size_t i = 0; i < size; ) {
+                if ( to_mutation_ == 0 )
+                    to_mutation_ = 1 + static_cast<std::size_t> ( -std::log ( rng_.unit ()) * rate );
+                const std::size_t n = std::min ( to_mutation_, size - i );
+                i += n;
+                to_mutation_ -= n;
+                if ( to_mutation_ == 0 )
+                    buffer [ i - 1 ] = alphabet [ rng_.below ( letters ) ];
+                }
+            }
+
+        corpus_kind kind_;
+        detail::random_source rng_;
+        std::uint64_t pos_;
+        std::uint64_t bits_;                    // uniform, dna, binary: unused random bits
+        unsigned nbits_;
+
+        std::vector<std::uint32_t> keep_;       // zipf_text: the alias table
+        std::vector<std::uint32_t> alias_;
+        std::string vocabulary_;                // zipf_text: word r, padded with spaces, at r * k_slot
+        std::vector<unsigned char> word_length_;
+        std::string word_;                      // zipf_text: the word being written
+        std::size_t word_pos_;                  // zipf_text: how much of it is written
+        std::string period_;                    // periodic
+        std::size_t period_pos_;
+        std::size_t to_mutation_;               // periodic, adversarial: bytes up to and including the next change
+
+        std::string pattern_;                   // planted copies
+        detail::random_source plant_rng_;
+        std::uint64_t next_plant_;              // where the next (or current) copy starts
+        double mean_gap_;
+        std::uint64_t planted_;
+        };
+
+
+    /// \fn make_corpus ( corpus_kind kind, std::size_t size, std::uint64_t seed )
+    /// \brief The first size bytes of the corpus
+    inline std::string make_corpus ( corpus_kind kind, std::size_t size, std::uint64_t seed = 1 ) {
+        std::string retVal ( size, '\0' );
+        corpus_generator ( kind, seed ).fill ( &retVal [ 0 ], size );
+        return retVal;
+        }
+
+    /// \fn make_pattern ( corpus_kind kind, std::size_t length, std::uint64_t seed )
+    /// \brief A pattern that looks like the corpus (for adversarial, a..aba..a)
+    ///
+    /// It is taken from a corpus with a different seed, so it may or may not
+    /// occur in the corpus being searched; plant it to be sure that it does.
+    ///
+    inline std::string make_pattern ( corpus_kind kind, std::size_t length, std::uint64_t seed = 1 ) {
+        if ( kind == corpus_kind::adversarial ) {
+            std::string retVal ( length, 'a' );
+            if ( length > 0 )
+                retVal [ length / 2 ] = 'b';
+            return retVal;
+            }
+    //  Skip ahead, so that a text pattern rarely starts at the beginning of a word
+        corpus_generator gen ( kind, ~seed );
+        std::string retVal ( length + 7, '\0' );
+        gen.fill ( &retVal [ 0 ], retVal.size ());
+        return retVal.substr ( 7 );
+        }
+
+    /// \fn make_absent_pattern ( corpus_kind kind, std::size_t length, std::uint64_t seed )
+    /// \brief make_pattern ( kind, length, seed ), with its middle byte replaced by k_absent_byte
+    ///
+    /// No corpus contains it (unless it is planted), but every byte except the
+    /// middle one agrees with the corpus, so near misses are common.
+    ///
+    inline std::string make_absent_pattern ( corpus_kind kind, std::size_t length, std::uint64_t seed = 1 ) {
+        if ( length == 0 )
+            throw std::invalid_argument ( "make_absent_pattern: every corpus contains the empty pattern" );
+        std::string retVal = make_pattern ( kind, length, seed );
+        retVal [ length / 2 ] = static_cast<char> ( k_absent_byte );
+        return retVal;
+        }
+}
+}
+
+#endif // TBA_WORKLOAD_HPP
@@ -0,0 +1,193 @@
+/*
+ (c) Copyright Marshall Clow 2013.
+
+ Distributed under the Boost Software License, Version 1.0.
+ http://www.boost.org/LICENSE_1_0.txt
+*/
+
+//	Times every searcher over every kind of corpus in workload.hpp.
+//
+//	workload_timing [MiB per corpus (default 64)] [seed (default 1)]
+//
+//	Each corpus is generated a chunk at a time, so it can be much larger than memory;
+//	only the searching is timed. For each kind and pattern length, the pattern is
+//	either planted (PLANTED_PER_MIB copies per MiB) or guaranteed absent.
+
+#include "searching.hpp"
+#include "packed_dna.hpp"
+#include "wildcard_search.hpp"
+#include "integer_search.hpp"
+#include "adaptive_search.hpp"
+#include "workload.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>	// for setprecision
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using tba::workload::corpus_kind;
+
+typedef std::chrono::duration<double> seconds;
+typedef std::chrono::high_resolution_clock hr_clock;
+
+const std::size_t CHUNK_SIZE = 16 * 1024 * 1024;
+const double PLANTED_PER_MIB = 4;
+
+//	Counts the matches in [first, last), adding the time it spent searching to elapsed
+typedef std::function<std::size_t ( const char *first, const char *last, seconds &elapsed )> match_counter;
+
+//	Every match, as a caller looping over search results would find them
+template <typename Searcher>
+match_counter find_all ( Searcher s ) {
+	return [s] ( const char *first, const char *last, seconds &elapsed ) {
+		const hr_clock::time_point start = hr_clock::now ();
+		std::size_t n = 0;
+		for ( const char *it = s ( first, last ); it != last; it = s ( it + 1, last ))
+			++n;
+		elapsed += hr_clock::now () - start;
+		return n;
+		};
+	}
+
+struct contender {
+	const char *name;
+	match_counter run;			// empty if it cannot search for this pattern
+	seconds elapsed;
+	std::size_t matches;
+	};
+
+std::vector<contender> make_contenders ( const std::string &pattern, corpus_kind kind ) {
+	const char *pFirst = pattern.data ();
+	const char *pLast  = pFirst + pattern.size ();
+	std::vector<contender> retVal;
+	auto add = [&retVal] ( const char *name, match_counter run ) {
+		retVal.push_back ( contender { name, run, seconds ( 0 ), 0 });
+		};
+
+	add ( "std",     find_all ( [pFirst, pLast] ( const char *f, const char *l ) { return std::search ( f, l, pFirst, pLast ); }));
+	add ( "default", find_all ( tba::make_searcher ( pFirst, pLast )));
+	add ( "bm",      find_all ( tba::make_boyer_moore_searcher ( pFirst, pLast )));
+	add ( "bmh",     find_all ( tba::make_boyer_moore_horspool_searcher ( pFirst, pLast )));
+	add ( "sunday",  find_all ( tba::make_sunday_searcher ( pFirst, pLast )));
+	add ( "raita",   find_all ( tba::make_raita_searcher ( pFirst, pLast )));
+	add ( "rare",    find_all ( tba::make_rare_byte_searcher ( pFirst, pLast )));
+	add ( "bndm",    find_all ( tba::make_bndm_searcher ( pFirst, pLast )));
+	add ( "bom",     find_all ( tba::make_backward_oracle_searcher ( pFirst, pLast )));
+	add ( "rk",      find_all ( tba::make_rabin_karp_searcher ( pFirst, pLast )));
+	add ( "integer", find_all ( tba::make_integer_searcher ( pFirst, pLast )));
+
+//	One decision for the whole stream, as a caller reading it a buffer at a time would keep it
+	const auto adaptive = tba::make_adaptive_searcher ( pFirst, pLast );
+	std::shared_ptr<tba::adaptive_state> state = std::make_shared<tba::adaptive_state> ();
+	add ( "adaptive", find_all ( [adaptive, state] ( const char *f, const char *l ) { return adaptive.search ( f, l, *state ); }));
+
+	match_counter wildcard;
+	if ( pattern.size () <= tba::wildcard_searcher::k_max_positions ) {
+		std::string escaped;
+		for ( char c : pattern ) {
+			escaped.push_back ( '\\' );
+			escaped.push_back ( c );
+			}
+		wildcard = find_all ( tba::make_wildcard_searcher ( escaped.begin (), escaped.end ()));
+		}
+	add ( "wildcard", wildcard );
+
+//	packed_dna searches its own representation; packing the chunk is not timed
+	match_counter packed;
+	if ( kind == corpus_kind::dna && pattern.find_first_not_of ( "ACGT" ) == std::string::npos ) {
+		std::shared_ptr<tba::packed_dna_searcher> s = std::make_shared<tba::packed_dna_searcher> ( pattern.begin (), pattern.end ());
+		packed = [s] ( const char *first, const char *last, seconds &elapsed ) {
+			const tba::packed_dna corpus ( first, last );
+			const hr_clock::time_point start = hr_clock::now ();
+			std::size_t n = 0;
+			for ( tba::packed_dna::const_iterator it = ( *s ) ( corpus.begin (), corpus.end ()); it != corpus.end (); it = ( *s ) ( it + 1, corpus.end ()))
+				++n;
+			elapsed += hr_clock::now () - start;
+			return n;
+			};
+		}
+	add ( "packed", packed );
+
+	auto bm = tba::make_boyer_moore_searcher ( pFirst, pLast );
+	add ( "count",   [bm] ( const char *first, const char *last, seconds &elapsed ) {
+		const hr_clock::time_point start = hr_clock::now ();
+		const std::size_t n = tba::count ( first, last, bm );
+		elapsed += hr_clock::now () - start;
+		return n;
+		});
+	return retVal;
+	}
+
+//	Streams size bytes of the corpus past every contender, carrying the last
+//	pattern.size () - 1 bytes of each chunk into the next so that no match is lost.
+void run_one ( corpus_kind kind, std::size_t m, bool present, std::uint64_t size, std::uint64_t seed ) {
+	const std::string pattern = present ? tba::workload::make_pattern ( kind, m, seed )
+	                                    : tba::workload::make_absent_pattern ( kind, m, seed );
+	std::vector<contender> contenders = make_contenders ( pattern, kind );
+
+	tba::workload::corpus_generator gen ( kind, seed );
+	if ( present )
+		gen.plant ( pattern, PLANTED_PER_MIB, seed );
+
+	const std::size_t keep = m - 1;
+	std::vector<char> buffer ( keep + CHUNK_SIZE );
+	std::size_t carried = 0;
+	while ( gen.position () < size ) {
+		const std::size_t n = static_cast<std::size_t> ( std::min<std::uint64_t> ( CHUNK_SIZE, size - gen.position ()));
+		gen.fill ( buffer.data () + carried, n );
+		const std::size_t valid = carried + n;
+		for ( contender &c : contenders )
+			if ( c.run )
+				c.matches += c.run ( buffer.data (), buffer.data () + valid, c.elapsed );
+		carried = std::min ( keep, valid );
+		std::copy ( buffer.begin () + ( valid - carried ), buffer.begin () + valid, buffer.begin ());
+		}
+
+	std::size_t expected = contenders.front ().matches;
+	if ( present ? expected < gen.planted () : expected != 0 )
+		std::cerr << "## " << tba::workload::kind_name ( kind ) << "/" << m << ": std::search found "
+		          << expected << " matches; " << gen.planted () << " were planted" << std::endl;
+
+	std::cout << std::setw ( 12 ) << tba::workload::kind_name ( kind ) << std::setw ( 6 ) << m
+	          << std::setw ( 9 ) << ( present ? "planted" : "absent" ) << std::setw ( 9 ) << expected;
+	for ( const contender &c : contenders ) {
+		if ( !c.run )
+			std::cout << std::setw ( 9 ) << "-";
+		else {
+			if ( c.matches != expected )
+				std::cerr << "## " << tba::workload::kind_name ( kind ) << "/" << m << ": " << c.name
+				          << " found " << c.matches << " matches, expected " << expected << std::endl;
+			std::cout << std::setw ( 9 ) << std::setprecision ( 0 ) << std::fixed
+			          << static_cast<double> ( size ) / ( 1048576.0 * c.elapsed.count ());
+			}
+		}
+	std::cout << std::endl;
+	}
+
+int main ( int argc, char *argv[] ) {
+	std::uint64_t mib  = argc > 1 ? std::strtoull ( argv[1], NULL, 10 ) : 64;
+	std::uint64_t seed = argc > 2 ? std::strtoull ( argv[2], NULL, 10 ) : 1;
+	if ( mib == 0 ) {
+		std::cerr << "Usage: " << argv[0] << " [MiB per corpus] [seed]" << std::endl;
+		return 1;
+		}
+
+	std::cout << "Corpus size = " << mib << " MiB, seed = " << seed
+	          << "; throughput in MiB/s, '-' where a searcher cannot take the pattern" << std::endl;
+	std::cout << std::setw ( 12 ) << "corpus" << std::setw ( 6 ) << "m" << std::setw ( 9 ) << "pattern" << std::setw ( 9 ) << "matches";
+	for ( const contender &c : make_contenders ( "ACGT", corpus_kind::dna ))
+		std::cout << std::setw ( 9 ) << c.name;
+	std::cout << std::endl;
+
+	const std::size_t lengths [] = { 8, 64, 512 };
+	for ( corpus_kind kind : tba::workload::all_kinds )
+		for ( std::size_t m : lengths )
+			for ( bool present : { true, false })
+				run_one ( kind, m, present, mib * 1048576, seed );
+	return 0;
+	}